@@ -0,0 +1,125 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+/**
+ * 用法：bench_ini [键的数量] [重复次数]
+ * 生成一个大的 config.ini，分别用 QSettings 和作用域（只读解析）读取所有键，打印每秒读取的键数
+ * 两者都会缓存解析结果，因此每次重复都读取文件的新副本
+ */
+
+namespace {
+
+QString keyAt(int index)
+{
+    return QStringLiteral("group%1/key%2").arg(index / 100).arg(index % 100);
+}
+
+// 普通的值、需要引号的值和需要转义的值各占三分之一
+QString valueAt(int index)
+{
+    switch (index % 3)
+    {
+    case 0:
+        return QStringLiteral("value-%1").arg(index);
+    case 1:
+        return QStringLiteral("a, b, %1").arg(index);
+    default:
+        return QStringLiteral("tab\t%1\n\"quoted\"").arg(index);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const auto arguments = app.arguments();
+    const auto key_count = arguments.size() > 1 ? arguments.at(1).toInt() : 100000;
+    const auto repeat = arguments.size() > 2 ? arguments.at(2).toInt() : 3;
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        std::fprintf(stderr, "cannot create temporary directory\n");
+        return 1;
+    }
+    const auto source = dir.filePath(QStringLiteral("config.ini"));
+    QStringList keys;
+    keys.reserve(key_count);
+    {
+        QSettings settings(source, QSettings::IniFormat);
+        for (auto i = 0; i < key_count; ++i)
+        {
+            keys.append(keyAt(i));
+            settings.setValue(keys.last(), valueAt(i));
+        }
+    }
+    const auto copy_of = [&dir, &source](const QString& name, int index) {
+        const auto file_path = dir.filePath(QStringLiteral("%1-%2.ini").arg(name).arg(index));
+        QFile::copy(source, file_path);
+        return file_path;
+    };
+
+    auto q_settings_time = std::numeric_limits<qint64>::max();
+    auto scope_time = std::numeric_limits<qint64>::max();
+    auto uses_ini_parser = true;
+    for (auto i = 0; i < repeat; ++i)
+    {
+        {
+            const auto file_path = copy_of(QStringLiteral("qsettings"), i);
+            QElapsedTimer timer;
+            timer.start();
+            QSettings settings(file_path, QSettings::IniFormat);
+            for (const auto& key : std::as_const(keys))
+            {
+                (void)settings.value(key);
+            }
+            q_settings_time = std::min(q_settings_time, timer.nsecsElapsed());
+        }
+        {
+            // 注册不计入耗时，第一次读取时解析文件
+            lzl::Settings::Scope scope(copy_of(QStringLiteral("scope"), i));
+            for (const auto& key : std::as_const(keys))
+            {
+                scope.registerSetting(key, QString());
+            }
+            QElapsedTimer timer;
+            timer.start();
+            for (const auto& key : std::as_const(keys))
+            {
+                scope.readValue(key, [](const QString&) {});
+            }
+            scope_time = std::min(scope_time, timer.nsecsElapsed());
+            uses_ini_parser = uses_ini_parser && scope.usesIniParser();
+        }
+    }
+
+    const auto keys_per_second = [key_count](qint64 nsecs) { return key_count / (std::max(nsecs, qint64(1)) / 1e9); };
+    const auto file_size = static_cast<long long>(QFile(source).size());
+    std::printf("keys: %d, repeat: %d, file: %lld bytes\n", key_count, repeat, file_size);
+    std::printf("%-12s %12s %14s\n", "reader", "time(ms)", "keys/s");
+    std::printf("%-12s %12.3f %14.0f\n", "QSettings", q_settings_time / 1e6, keys_per_second(q_settings_time));
+    std::printf("%-12s %12.3f %14.0f\n", "IniFile", scope_time / 1e6, keys_per_second(scope_time));
+    if (!uses_ini_parser)
+    {
+        std::printf("warning: the file could not be parsed, the scope fell back to QSettings\n");
+    }
+    return 0;
+}
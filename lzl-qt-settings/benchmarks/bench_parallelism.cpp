@@ -0,0 +1,97 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+/**
+ * 用法：bench_parallelism [键的数量] [重复次数]
+ * 对 setParallelism(1, 2, 4, 8, 16) 分别运行 exportGroup 和 validateAll，打印每种线程数的最短耗时
+ */
+
+namespace {
+
+const auto Group = QStringLiteral("bench");
+
+// 取多次运行中最短的耗时，减少其他进程的干扰
+qint64 bestOf(int repeat, const std::function<void()>& func)
+{
+    auto best = std::numeric_limits<qint64>::max();
+    for (auto i = 0; i < repeat; ++i)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        func();
+        best = std::min(best, timer.nsecsElapsed());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const auto arguments = app.arguments();
+    const auto key_count = arguments.size() > 1 ? arguments.at(1).toInt() : 20000;
+    const auto repeat = arguments.size() > 2 ? arguments.at(2).toInt() : 5;
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        std::fprintf(stderr, "cannot create temporary directory\n");
+        return 1;
+    }
+    const auto file_path = dir.filePath(QStringLiteral("config.ini"));
+    {
+        // 直接写文件，不计入基准
+        QSettings settings(file_path, QSettings::IniFormat);
+        for (auto i = 0; i < key_count; ++i)
+        {
+            settings.setValue(QStringLiteral("%1/key%2").arg(Group).arg(i), QStringLiteral("value-%1").arg(i));
+        }
+    }
+
+    // 检查函数有一定的开销，可以在多个线程中同时调用（QRegularExpression 的匹配是可重入的）
+    const QRegularExpression pattern(QStringLiteral("^value-\\d+$"));
+    lzl::Settings::Scope scope(file_path);
+    for (auto i = 0; i < key_count; ++i)
+    {
+        scope.registerSetting(
+            QStringLiteral("%1/key%2").arg(Group).arg(i),
+            QStringLiteral("default"),
+            [&pattern](const QVariant& value) { return pattern.match(value.toString()).hasMatch(); }
+        );
+    }
+
+    std::printf("keys: %d, repeat: %d\n", key_count, repeat);
+    std::printf("%8s %16s %16s\n", "threads", "exportGroup(ms)", "validateAll(ms)");
+    for (const auto threads : {1, 2, 4, 8, 16})
+    {
+        lzl::Settings::setParallelism(threads);
+        const auto export_time = bestOf(repeat, [&scope]() {
+            QBuffer buffer;
+            buffer.open(QIODevice::WriteOnly);
+            scope.exportGroup(Group, &buffer);
+        });
+        const auto validate_time = bestOf(repeat, [&scope]() { (void)scope.validateAll(); });
+        std::printf("%8d %16.3f %16.3f\n", threads, export_time / 1e6, validate_time / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * 用法：bench_registry [组的数量] [每组的键数] [重复次数]
+ * 注册所有键、逐个注销组、析构作用域（一次释放整个注册表），打印每一步的最短耗时
+ * 分别在没有和有 4 个线程同时查找时运行：查找的线程持有旧快照，快照的节点会在这些线程中释放
+ */
+
+namespace {
+
+QString keyAt(int group, int index)
+{
+    return QStringLiteral("group%1/sub%2/key%3").arg(group).arg(index % 8).arg(index);
+}
+
+struct Times
+{
+    qint64 register_ns = std::numeric_limits<qint64>::max();
+    qint64 deregister_ns = std::numeric_limits<qint64>::max();
+    qint64 destroy_ns = std::numeric_limits<qint64>::max();
+};
+
+qint64 elapsed(QElapsedTimer& timer)
+{
+    const auto ns = timer.nsecsElapsed();
+    timer.restart();
+    return ns;
+}
+
+// 取多次运行中最短的耗时，减少其他进程的干扰
+Times run(const QString& file_path, int group_count, int key_count, int reader_count, int repeat)
+{
+    Times best;
+    for (auto r = 0; r < repeat; ++r)
+    {
+        auto scope = std::make_unique<lzl::Settings::Scope>(file_path);
+        std::atomic<bool> stop{false};
+        std::vector<std::thread> readers;
+        for (auto i = 0; i < reader_count; ++i)
+        {
+            readers.emplace_back([&scope, &stop, group_count, key_count, i]() {
+                for (auto n = i; !stop.load(std::memory_order_relaxed); ++n)
+                {
+                    (void)scope->containsKey(keyAt(n % group_count, n % key_count));
+                }
+            });
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (auto g = 0; g < group_count; ++g)
+        {
+            for (auto k = 0; k < key_count; ++k)
+            {
+                scope->registerSetting(keyAt(g, k), k);
+            }
+        }
+        best.register_ns = std::min(best.register_ns, elapsed(timer));
+        for (auto g = 0; g < group_count; ++g)
+        {
+            scope->deRegisterSettingGroup(QStringLiteral("group%1").arg(g));
+        }
+        best.deregister_ns = std::min(best.deregister_ns, elapsed(timer));
+
+        stop.store(true, std::memory_order_relaxed);
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+        for (auto g = 0; g < group_count; ++g)
+        {
+            for (auto k = 0; k < key_count; ++k)
+            {
+                scope->registerSetting(keyAt(g, k), k);
+            }
+        }
+        timer.restart();
+        scope.reset();
+        best.destroy_ns = std::min(best.destroy_ns, elapsed(timer));
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    const auto arguments = app.arguments();
+    const auto group_count = arguments.size() > 1 ? arguments.at(1).toInt() : 100;
+    const auto key_count = arguments.size() > 2 ? arguments.at(2).toInt() : 200;
+    const auto repeat = arguments.size() > 3 ? arguments.at(3).toInt() : 5;
+
+    QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        std::fprintf(stderr, "cannot create temporary directory\n");
+        return 1;
+    }
+    const auto file_path = dir.filePath(QStringLiteral("config.ini"));
+
+    std::printf("groups: %d, keys per group: %d, repeat: %d\n", group_count, key_count, repeat);
+    std::printf("%8s %14s %16s %14s\n", "readers", "register(ms)", "deregister(ms)", "destroy(ms)");
+    for (const auto readers : {0, 4})
+    {
+        const auto times = run(file_path, group_count, key_count, readers, repeat);
+        std::printf(
+            "%8d %14.3f %16.3f %14.3f\n",
+            readers,
+            times.register_ns / 1e6,
+            times.deregister_ns / 1e6,
+            times.destroy_ns / 1e6
+        );
+    }
+    return 0;
+}
@@ -0,0 +1,302 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+/**
+ * 随机交错注册、注销、绑定、解绑、写入和触发，每个操作之后调用 checkIntegrity，发现问题时打印并终止
+ *
+ * 使用 libFuzzer（定义了 LZL_SETTINGS_LIBFUZZER）时每两个字节是一个操作：操作码和参数；
+ * 否则用 main 按种子生成随机输入：fuzz_settings [输入数量] [种子] [每个输入的操作数]，结束时打印 ops/s
+ */
+
+namespace {
+
+constexpr int PlainKeyCount = 16; // fuzz/g0/k0 到 fuzz/g3/k3
+constexpr int InstanceCount = 4;  // fuzz/doc/d0 到 fuzz/doc/d3
+constexpr int TemplateKeyCount = 4;
+
+const QStringList Patterns{QStringLiteral("fuzz/**"), QStringLiteral("fuzz/g1/*"), QStringLiteral("fuzz/doc/*/t0")};
+
+QString plainKey(int index)
+{
+    return QStringLiteral("fuzz/g%1/k%2").arg(index / 4).arg(index % 4);
+}
+
+QString instanceKey(int instance, int index)
+{
+    return QStringLiteral("fuzz/doc/d%1/t%2").arg(instance).arg(index);
+}
+
+bool checkValue(const QVariant& value)
+{
+    return value.toString() != QStringLiteral("invalid");
+}
+
+/**
+ * @brief Model 记录已经注册的键和存在的读取事件，只对存在的键和读取事件操作；用数组而不是 QSet 保证可以复现
+ */
+class Model final
+{
+public:
+    void reset()
+    {
+        lzl::Settings::disconnectAllSettingsReadValues();
+        lzl::Settings::deRegisterAllSettings();
+        for (auto i = 0; i < TemplateKeyCount; ++i)
+        {
+            lzl::Settings::registerSetting(QStringLiteral("fuzz/doc/*/t%1").arg(i), i, checkValue);
+        }
+        m_registered.assign(PlainKeyCount, false);
+        m_instances.assign(InstanceCount, false);
+        m_conns.clear();
+    }
+
+    void run(std::uint8_t op, std::uint8_t arg)
+    {
+        switch (op % 14)
+        {
+        case 0:
+            if (const auto index = arg % PlainKeyCount; !m_registered[index])
+            {
+                lzl::Settings::registerSetting(plainKey(index), QStringLiteral("default"), checkValue);
+                m_registered[index] = true;
+            }
+            break;
+        case 1:
+            if (const auto index = arg % PlainKeyCount; m_registered[index])
+            {
+                lzl::Settings::deRegisterSettingKey(plainKey(index));
+                m_registered[index] = false;
+                dropConns(plainKey(index));
+            }
+            break;
+        case 2:
+            deRegisterGroup(arg % (PlainKeyCount / 4));
+            break;
+        case 3:
+            if (const auto index = arg % InstanceCount; !m_instances[index])
+            {
+                const QVariantHash defaults{{QStringLiteral("t0"), static_cast<int>(arg)}};
+                lzl::Settings::registerInstance(QStringLiteral("fuzz/doc"), QStringLiteral("d%1").arg(index), defaults);
+                m_instances[index] = true;
+            }
+            break;
+        case 4:
+            if (const auto index = arg % InstanceCount; m_instances[index])
+            {
+                lzl::Settings::deRegisterInstance(QStringLiteral("fuzz/doc"), QStringLiteral("d%1").arg(index));
+                m_instances[index] = false;
+                dropConns(QStringLiteral("fuzz/doc/d%1/").arg(index));
+            }
+            break;
+        case 5:
+            if (const auto key = liveKey(arg); !key.isEmpty())
+            {
+                m_conns.push_back({lzl::Settings::connectReadValue(key, [](const QString&) {}), key});
+            }
+            break;
+        case 6:
+            if (const auto key = liveKey(arg); !key.isEmpty())
+            {
+                const auto id = lzl::Settings::connectValueChanged(key, [](const QString&, const QString&) {});
+                m_conns.push_back({id, key});
+            }
+            break;
+        case 7:
+        {
+            const auto& pattern = Patterns.at(arg % Patterns.size());
+            const auto read = [](const QString&, const QVariant&) {};
+            m_conns.push_back({lzl::Settings::connectReadValuesFromPattern(pattern, read), {}});
+            break;
+        }
+        case 8:
+            if (!m_conns.empty())
+            {
+                const auto it = m_conns.begin() + arg % m_conns.size();
+                lzl::Settings::disconnectReadValue(it->first);
+                m_conns.erase(it);
+            }
+            break;
+        case 9:
+            if (const auto key = liveKey(arg); !key.isEmpty())
+            {
+                // 八分之一是非法值
+                const auto value = arg % 8 == 0 ? QVariant(QStringLiteral("invalid")) : QVariant(static_cast<int>(arg));
+                lzl::Settings::writeValue(key, value, arg & 1);
+            }
+            break;
+        case 10:
+            if (!m_conns.empty())
+            {
+                lzl::Settings::emitReadValue(m_conns.at(arg % m_conns.size()).first);
+            }
+            break;
+        case 11:
+            if (const auto key = liveKey(arg); !key.isEmpty())
+            {
+                lzl::Settings::emitReadValuesFromKey(key);
+            }
+            break;
+        case 12:
+            lzl::Settings::emitReadValuesFromGroupDeferred(QStringLiteral("fuzz"), arg % 3);
+            break;
+        default:
+            QCoreApplication::processEvents();
+            break;
+        }
+    }
+
+private:
+    // 注册的键和实例的键，按固定的顺序选择第 arg 个，没有时返回空
+    QString liveKey(std::uint8_t arg) const
+    {
+        QStringList keys;
+        for (auto i = 0; i < PlainKeyCount; ++i)
+        {
+            if (m_registered[i])
+            {
+                keys.append(plainKey(i));
+            }
+        }
+        for (auto i = 0; i < InstanceCount; ++i)
+        {
+            for (auto j = 0; m_instances[i] && j < TemplateKeyCount; ++j)
+            {
+                keys.append(instanceKey(i, j));
+            }
+        }
+        return keys.isEmpty() ? QString() : keys.at(arg % keys.size());
+    }
+
+    void deRegisterGroup(int group)
+    {
+        auto found = false;
+        for (auto i = group * 4; i < group * 4 + 4; ++i)
+        {
+            found = found || m_registered[i];
+            m_registered[i] = false;
+        }
+        if (found)
+        {
+            const auto dir = QStringLiteral("fuzz/g%1").arg(group);
+            lzl::Settings::deRegisterSettingGroup(dir);
+            dropConns(dir + QLatin1Char('/'));
+        }
+    }
+
+    // 注销后键的读取事件已经被断开，从模型中删除键是 key 或以 key 开头的读取事件，模式的读取事件保留
+    void dropConns(const QString& key)
+    {
+        for (auto it = m_conns.begin(); it != m_conns.end();)
+        {
+            const auto& conn_key = it->second;
+            const auto under = key.endsWith(QLatin1Char('/')) && conn_key.startsWith(key);
+            const auto matched = !conn_key.isEmpty() && (conn_key == key || under);
+            it = matched ? m_conns.erase(it) : std::next(it);
+        }
+    }
+
+    std::vector<bool> m_registered;
+    std::vector<bool> m_instances;
+    std::vector<std::pair<lzl::Settings::ConnId, QString>> m_conns;
+};
+
+// 设置文件放在临时目录中，必须在第一次使用全局作用域之前设置
+void initialize(int& argc, char** argv)
+{
+    static QCoreApplication app(argc, argv);
+    static QTemporaryDir dir;
+    if (!dir.isValid())
+    {
+        std::fprintf(stderr, "cannot create temporary directory\n");
+        std::abort();
+    }
+    lzl::Settings::InitIniDirectory(dir.path());
+}
+
+// 执行一个输入，返回执行的操作数
+int runInput(const std::uint8_t* data, std::size_t size)
+{
+    static Model model;
+    model.reset();
+    auto ops = 0;
+    for (std::size_t i = 0; i + 1 < size; i += 2, ++ops)
+    {
+        model.run(data[i], data[i + 1]);
+        if (const auto issues = lzl::Settings::checkIntegrity(); !issues.isEmpty())
+        {
+            std::fprintf(stderr, "integrity check failed after op %d (%u, %u):\n", ops, data[i], data[i + 1]);
+            for (const auto& issue : issues)
+            {
+                std::fprintf(stderr, "  %s\n", qPrintable(issue));
+            }
+            std::abort();
+        }
+    }
+    return ops;
+}
+
+} // namespace
+
+#ifdef LZL_SETTINGS_LIBFUZZER
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv)
+{
+    initialize(*argc, *argv);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size)
+{
+    runInput(data, size);
+    return 0;
+}
+
+#else
+
+int main(int argc, char* argv[])
+{
+    initialize(argc, argv);
+    const auto arguments = QCoreApplication::arguments();
+    const auto inputs = arguments.size() > 1 ? arguments.at(1).toInt() : 1000;
+    const auto seed = arguments.size() > 2 ? arguments.at(2).toUInt() : std::random_device{}();
+    const auto ops_per_input = arguments.size() > 3 ? arguments.at(3).toInt() : 256;
+
+    std::mt19937 engine(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::uint8_t> data(static_cast<std::size_t>(ops_per_input) * 2);
+    qint64 ops = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (auto i = 0; i < inputs; ++i)
+    {
+        for (auto& value : data)
+        {
+            value = static_cast<std::uint8_t>(byte(engine));
+        }
+        ops += runInput(data.data(), data.size());
+    }
+    const auto seconds = std::max(timer.nsecsElapsed(), qint64(1)) / 1e9;
+    std::printf("seed: %u, inputs: %d, ops: %lld, %.0f ops/s\n", seed, inputs, ops, ops / seconds);
+    return 0;
+}
+
+#endif
@@ -94,6 +94,27 @@ struct ConvertQVariant<const QPoint&>
     static auto convert(const QVariant& value) { return value.toPoint(); }
 };
 
+// By-value Qt types convert the same as their const references (e.g. for readValueAsync)
+template <>
+struct ConvertQVariant<QString> : ConvertQVariant<const QString&>
+{
+};
+
+template <>
+struct ConvertQVariant<QRect> : ConvertQVariant<const QRect&>
+{
+};
+
+template <>
+struct ConvertQVariant<QSize> : ConvertQVariant<const QSize&>
+{
+};
+
+template <>
+struct ConvertQVariant<QPoint> : ConvertQVariant<const QPoint&>
+{
+};
+
 // more ... ...
 
 } // namespace lzl::utils
@@ -8,445 +8,5011 @@
 
 #include "lzl_settings.h"
 
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMutex>
-#include <QRegularExpression>
+#include <QPoint>
+#include <QRect>
+#include <QRunnable>
+#include <QScopeGuard>
+#include <QSemaphore>
+#include <QSize>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#if QT_CONFIG(sharedmemory)
+    #include <QSharedMemory>
+#endif
+#ifdef LZL_QT_SETTINGS_BROKER
+    #include <QLocalServer>
+    #include <QLocalSocket>
+#endif
+
+#include <atomic>
+#include <limits>
+#include <new>
+#include <vector>
 
 #ifndef CONFIG_INI
     #define CONFIG_INI "config.ini"
 #endif
 
+// 未启用统计时计数语句不会被编译
+#ifdef LZL_QT_SETTINGS_STATS
+    #define LZL_SETTINGS_STATS_INC(counter) (++(counter))
+#else
+    #define LZL_SETTINGS_STATS_INC(counter) ((void)0)
+#endif
+
 namespace lzl::utils {
 
 namespace {
 const auto _g_connIdMetaTypeId = qRegisterMetaType<Settings::ConnId>("lzl::utils::Settings::ConnId");
+
+#ifdef LZL_QT_SETTINGS_TRACE
+struct TraceEvent final
+{
+    const char* name;
+    QString key;
+    std::size_t conn_id;
+    qint64 begin_ns;
+    qint64 duration_ns;
+    int depth;
+};
+
+struct TraceState final
+{
+    bool active = false;
+    int capacity = 0;
+    int depth = 0; // 与 active 无关，保证中途开始或停止时深度依然正确
+    quint64 dropped = 0;
+    QElapsedTimer clock;
+    QList<TraceEvent> events;
+};
+
+TraceState& traceState()
+{
+    static TraceState state;
+    return state;
+}
+
+/**
+ * @brief TraceScope 在作用域结束时记录一个完整事件（Chrome trace 的 "X" 事件）
+ */
+class TraceScope final
+{
+public:
+    TraceScope(const char* name, const QString& key, std::size_t conn_id = 0)
+    {
+        auto& state = traceState();
+        m_event = {name, {}, conn_id, 0, 0, state.depth++};
+        if (state.active)
+        {
+            m_event.key = key;
+            m_event.begin_ns = state.clock.nsecsElapsed();
+        }
+        m_recording = state.active;
+    }
+
+    ~TraceScope()
+    {
+        auto& state = traceState();
+        --state.depth;
+        if (!m_recording || !state.active)
+        {
+            return;
+        }
+        if (state.events.size() >= state.capacity)
+        {
+            ++state.dropped;
+            return;
+        }
+        m_event.duration_ns = state.clock.nsecsElapsed() - m_event.begin_ns;
+        state.events.append(std::move(m_event));
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceEvent m_event;
+    bool m_recording;
+};
+#endif
 } // namespace
 
-// 实例构造
-/* ========================================================================== */
+namespace {
+/**
+ * @brief NodePool 注册表节点的内存池，按块批量申请，释放的节点放回空闲链表而不是还给系统
+ * @note 每个线程有自己的空闲链表，申请和释放不加锁；线程的链表为空时从共享的批次中取一批，
+ *       超过两批时把较早释放的节点作为一批交回，因此每一批节点才加一次锁
+ * @note 旧快照可能在其他线程中释放，节点会在线程之间流动；线程退出时把它的链表整批交回
+ */
+template <std::size_t Size, std::size_t Align>
+class NodePool final
+{
+public:
+    static NodePool& instance()
+    {
+        // 不析构：全局作用域不会析构，退出时它的节点依然指向内存池；线程退出时也依然可以交回节点
+        static auto pool = new NodePool;
+        return *pool;
+    }
 
-Settings* Settings::s_instance = nullptr;
-QString Settings::s_ini_directory = {};
-QString Settings::s_ini_file_name = {};
+    void* allocate()
+    {
+        auto& cache = localCache();
+        if (cache.free == nullptr)
+        {
+            const auto batch = takeBatch();
+            cache.free = batch.head;
+            cache.count = batch.count;
+        }
+        auto block = cache.free;
+        cache.free = block->next;
+        --cache.count;
+        return block;
+    }
+
+    void deallocate(void* ptr)
+    {
+        auto& cache = localCache();
+        auto block = static_cast<Block*>(ptr);
+        block->next = cache.free;
+        cache.free = block;
+        if (++cache.count < 2 * ChunkSize)
+        {
+            return;
+        }
+        // 保留最近释放的一批，它们更可能还在缓存中
+        auto last = cache.free;
+        for (std::size_t i = 1; i < ChunkSize; ++i)
+        {
+            last = last->next;
+        }
+        putBatch({last->next, cache.count - ChunkSize});
+        last->next = nullptr;
+        cache.count = ChunkSize;
+    }
+
+private:
+    static constexpr std::size_t ChunkSize = 64;
+
+    union Block
+    {
+        Block* next;
+        alignas(Align) unsigned char storage[Size];
+    };
+
+    struct Batch
+    {
+        Block* head;
+        std::size_t count;
+    };
+
+    struct LocalCache final
+    {
+        Block* free = nullptr;
+        std::size_t count = 0;
+
+        ~LocalCache()
+        {
+            if (free != nullptr)
+            {
+                instance().putBatch({free, count});
+            }
+        }
+    };
+
+    static LocalCache& localCache()
+    {
+        thread_local LocalCache cache;
+        return cache;
+    }
+
+    Batch takeBatch()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_batches.empty())
+        {
+            const auto batch = m_batches.back();
+            m_batches.pop_back();
+            return batch;
+        }
+        // 一次申请一整块，相邻申请的节点在内存中也相邻
+        auto chunk = std::make_unique<Block[]>(ChunkSize);
+        for (std::size_t i = 0; i + 1 < ChunkSize; ++i)
+        {
+            chunk[i].next = &chunk[i + 1];
+        }
+        chunk[ChunkSize - 1].next = nullptr;
+        const Batch batch{&chunk[0], ChunkSize};
+        m_chunks.push_back(std::move(chunk));
+        return batch;
+    }
+
+    void putBatch(const Batch& batch)
+    {
+        QMutexLocker locker(&m_mutex);
+        m_batches.push_back(batch);
+    }
 
-Settings& Settings::instance()
+    QMutex m_mutex;
+    std::vector<Batch> m_batches;
+    std::vector<std::unique_ptr<Block[]>> m_chunks;
+};
+
+/**
+ * @brief PoolAllocator 供 std::allocate_shared 使用，节点和引用计数在同一个块中
+ */
+template <typename T>
+struct PoolAllocator final
 {
-    if (s_instance == nullptr)
+    using value_type = T;
+
+    PoolAllocator() = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept
     {
-        static QMutex mutex;
-        QMutexLocker locker(&mutex);
-        if (s_instance == nullptr)
+    }
+
+    T* allocate(std::size_t n)
+    {
+        if (n != 1)
         {
-            s_instance = new Settings([] {
-                if (!s_ini_file_name.isEmpty())
-                {
-                    return QDir(s_ini_directory).filePath(s_ini_file_name);
-                }
-                if (QDir::isRelativePath(CONFIG_INI))
-                {
-                    return QDir(s_ini_directory).filePath(QStringLiteral(CONFIG_INI));
-                }
-                return QStringLiteral(CONFIG_INI);
-            }());
+            return std::allocator<T>().allocate(n);
         }
+        return static_cast<T*>(NodePool<sizeof(T), alignof(T)>::instance().allocate());
     }
-    return *s_instance;
+
+    void deallocate(T* ptr, std::size_t n)
+    {
+        if (n != 1)
+        {
+            std::allocator<T>().deallocate(ptr, n);
+            return;
+        }
+        NodePool<sizeof(T), alignof(T)>::instance().deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept
+    {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept
+    {
+        return false;
+    }
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> makeNode(Args&&... args)
+{
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
 }
 
-Settings::Settings(const QString& file_name, QObject* parent) : m_q_settings(file_name, QSettings::IniFormat, parent) {}
+/**
+ * @brief SegmentTable 路径段的驻留表，id 0 保留表示不存在
+ * @note 查找不加锁：段只写入一次且不可变，哈希表和 id 数组扩容时复制到新的数组再原子地发布；
+ *       只有驻留新的段时加锁。旧的数组不释放，读者可能还在使用，容量成倍增长，因此它们的总大小不超过当前的数组
+ * @note 不析构，理由同 NodePool
+ */
+class SegmentTable final
+{
+public:
+    static SegmentTable& instance()
+    {
+        static auto table = new SegmentTable;
+        return *table;
+    }
 
-void Settings::InitIniDirectory(const QString& directory) noexcept
+    quint32 find(const QString& word) const
+    {
+        const auto entry = findEntry(word, hashOf(word));
+        return entry != nullptr ? entry->id : 0;
+    }
+
+    quint32 intern(const QString& word)
+    {
+        const auto hash = hashOf(word);
+        if (const auto entry = findEntry(word, hash); entry != nullptr)
+        {
+            return entry->id;
+        }
+        QMutexLocker locker(&m_mutex);
+        // 加锁期间可能已经被其他线程驻留
+        if (const auto entry = findEntry(word, hash); entry != nullptr)
+        {
+            return entry->id;
+        }
+        const auto entry = new Entry{word, hash, m_size};
+        // 先发布 id 再发布哈希，读者查找到的 id 一定能取得名字
+        auto ids = m_ids.load(std::memory_order_relaxed);
+        if (entry->id == ids->capacity)
+        {
+            ids = grow(ids, ids->capacity * 2, false);
+            m_ids.store(ids, std::memory_order_release);
+        }
+        ids->slots[entry->id].store(entry, std::memory_order_release);
+        ++m_size;
+        // 负载不超过一半，查找时一定能遇到空位
+        auto index = m_index.load(std::memory_order_relaxed);
+        if (m_size * 2 > index->capacity)
+        {
+            index = grow(ids, index->capacity * 2, true);
+            m_index.store(index, std::memory_order_release);
+        }
+        else
+        {
+            insert(index, entry);
+        }
+        return entry->id;
+    }
+
+    QString name(quint32 id) const
+    {
+        const auto ids = m_ids.load(std::memory_order_acquire);
+        const auto entry = id < ids->capacity ? ids->slots[id].load(std::memory_order_acquire) : nullptr;
+        return entry != nullptr ? entry->name : QString();
+    }
+
+private:
+    struct Entry final
+    {
+        QString name;
+        quint32 hash;
+        quint32 id;
+    };
+
+    // 哈希表（容量是 2 的幂，开放寻址）和 id 数组使用同样的结构
+    struct Slots final
+    {
+        explicit Slots(quint32 capacity) : capacity(capacity), slots(new std::atomic<const Entry*>[capacity])
+        {
+            for (quint32 i = 0; i < capacity; ++i)
+            {
+                slots[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        const quint32 capacity;
+        std::unique_ptr<std::atomic<const Entry*>[]> slots;
+    };
+
+    SegmentTable() : m_index(new Slots(InitialCapacity)), m_ids(new Slots(InitialCapacity)) {}
+
+    static quint32 hashOf(const QString& word) { return static_cast<quint32>(qHash(word)); }
+
+    const Entry* findEntry(const QString& word, quint32 hash) const
+    {
+        const auto index = m_index.load(std::memory_order_acquire);
+        const auto mask = index->capacity - 1;
+        for (auto i = hash & mask;; i = (i + 1) & mask)
+        {
+            const auto entry = index->slots[i].load(std::memory_order_acquire);
+            if (entry == nullptr || (entry->hash == hash && entry->name == word))
+            {
+                return entry;
+            }
+        }
+    }
+
+    static void insert(Slots* index, const Entry* entry)
+    {
+        const auto mask = index->capacity - 1;
+        auto i = entry->hash & mask;
+        while (index->slots[i].load(std::memory_order_relaxed) != nullptr)
+        {
+            i = (i + 1) & mask;
+        }
+        index->slots[i].store(entry, std::memory_order_release);
+    }
+
+    // 只在加锁时调用，as_index 为真时从 id 数组重建哈希表，否则复制 id 数组
+    Slots* grow(const Slots* ids, quint32 capacity, bool as_index)
+    {
+        auto result = new Slots(capacity);
+        for (quint32 id = 1; id < m_size; ++id)
+        {
+            const auto entry = ids->slots[id].load(std::memory_order_relaxed);
+            if (as_index)
+            {
+                insert(result, entry);
+            }
+            else
+            {
+                result->slots[id].store(entry, std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+
+    static constexpr quint32 InitialCapacity = 256;
+
+    QMutex m_mutex;
+    quint32 m_size = 1; // 下一个 id，只在加锁时访问
+    std::atomic<Slots*> m_index;
+    std::atomic<Slots*> m_ids;
+};
+
+// 启动缓存文件的格式，格式变化时增加版本号
+constexpr quint32 StartupCacheMagic = 0x4C5A4C43; // "LZLC"
+constexpr quint32 StartupCacheVersion = 1;
+
+// 二进制导出的文件头，条目以空键结束
+constexpr quint32 ExportMagic = 0x4C5A4C45; // "LZLE"
+constexpr quint32 ExportVersion = 1;
+
+// 多进程共享内存的格式，格式变化时增加版本号
+constexpr quint32 SharedMagic = 0x4C5A4C53; // "LZLS"
+constexpr quint32 SharedVersion = 1;
+constexpr quint32 SharedSlotCount = 4096;
+
+/**
+ * @brief SharedHeader 共享内存的开头，之后是 SharedSlotCount 个 SharedSlot
+ * @note counter 不加锁读取，因此必须是无锁的原子量（跨进程时才是同一个变量）；其他字段只在加锁时访问
+ */
+struct SharedHeader final
 {
-    Q_ASSERT_X(
-        s_instance == nullptr,
-        Q_FUNC_INFO,
-        QStringLiteral("The function must be called before 'Settings' initialization.").toUtf8().constData()
-    );
-    s_ini_directory = directory;
+    quint32 magic = SharedMagic;
+    quint32 version = SharedVersion;
+    std::atomic<quint64> counter{0}; // 每次发布修改加一
+    quint64 reload_counter = 0;      // 需要重新读取所有键的最后一次修改，如清空设置文件或槽位用尽
+};
+static_assert(std::atomic<quint64>::is_always_lock_free, "Shared counter must be lock free.");
+
+/**
+ * @brief SharedSlot 一个键最后一次修改时的计数，按键的哈希线性探测，槽位只占用不释放
+ * @note 哈希冲突的键共用一个槽位，只会让另一个键多重新读取一次
+ */
+struct SharedSlot final
+{
+    quint32 hash; // 0 表示空槽位
+    quint32 reserved;
+    quint64 counter;
+};
+
+/**
+ * @brief FunctionTask 在线程池中执行的函数，兼容没有 QThreadPool::start(std::function) 的 Qt 版本
+ */
+class FunctionTask final : public QRunnable
+{
+public:
+    explicit FunctionTask(std::function<void()>&& func) : m_func(std::move(func)) {}
+    void run() override { m_func(); }
+
+private:
+    std::function<void()> m_func;
+};
+
+/**
+ * @brief parallelFor 在全局线程池和当前线程中并行执行 func(0) 到 func(count - 1)，返回时全部执行完毕
+ * @note 各线程从同一个原子计数中领取下一个分片，快的线程自然多做，不需要预先平均分配；
+ *       线程池繁忙时当前线程会做完所有分片，之后用 tryTake 取回还没开始的任务，只等待已经开始的任务，
+ *       因此在线程池的线程中调用（线程池已满）也不会死锁
+ */
+void parallelFor(int count, int parallelism, const std::function<void(int)>& func)
+{
+    if (parallelism <= 0)
+    {
+        parallelism = QThread::idealThreadCount();
+    }
+    const auto workers = std::min(parallelism, count) - 1;
+    if (workers <= 0)
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<int> next{0};
+    QSemaphore done;
+    const auto run = [&next, &func, count]() {
+        for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            func(i);
+        }
+    };
+    // 任务不自动删除，取回时不会被线程池删除
+    std::vector<std::unique_ptr<FunctionTask>> tasks;
+    tasks.reserve(static_cast<std::size_t>(workers));
+    const auto pool = QThreadPool::globalInstance();
+    for (auto i = 0; i < workers; ++i)
+    {
+        tasks.push_back(std::make_unique<FunctionTask>([&run, &done]() {
+            run();
+            done.release();
+        }));
+        tasks.back()->setAutoDelete(false);
+        pool->start(tasks.back().get());
+    }
+    run();
+    auto started = workers;
+    for (const auto& task : tasks)
+    {
+        if (pool->tryTake(task.get()))
+        {
+            --started;
+        }
+    }
+    done.acquire(started);
 }
 
-void Settings::InitIniFilePath(const QString& file_path)
+/**
+ * @brief sharedKeyHash 各个进程都相同的键的哈希（FNV-1a），不使用随机种子的 qHash
+ */
+quint32 sharedKeyHash(const QString& key)
 {
-    Q_ASSERT_X(
-        s_instance == nullptr,
-        Q_FUNC_INFO,
-        QStringLiteral("The function must be called before 'Settings' initialization.").toUtf8().constData()
-    );
-    QFileInfo fileinfo(file_path);
-    Q_ASSERT_X(
-        fileinfo.suffix() == "ini", Q_FUNC_INFO, QStringLiteral("The file suffix must be 'ini'.").toUtf8().constData()
-    );
-    s_ini_file_name = fileinfo.fileName();
-    s_ini_directory = fileinfo.path();
+    quint32 hash = 2166136261u;
+    for (const auto c : key.toUtf8())
+    {
+        hash = (hash ^ static_cast<quint8>(c)) * 16777619u;
+    }
+    return hash == 0 ? 1 : hash;
 }
 
-// 注册表相关类的成员函数
-/* ========================================================================== */
+/**
+ * @brief BrokerMessage 本地设置代理的消息，每条消息以类型开头，之后的内容见各个类型
+ * @note 消息直接写入套接字，读取时使用 QDataStream 的事务等待完整的消息
+ */
+enum class BrokerMessage : quint8
+{
+    Read = 1, // 客户端：QStringList 键，为空则是所有键
+    Values,   // 代理：QVariantHash 键和值，回复 Read
+    Write,    // 客户端：QVariantHash 写入的键和值
+    Remove,   // 客户端：QStringList 删除的路径（键或组），空路径表示清空
+    Changed,  // 代理：QVariantHash 写入的键和值、QStringList 删除的路径，推送给其他客户端
+};
+
+// 代理接受的单条消息的最大长度，超过时断开客户端，避免无限地缓存不完整的消息
+constexpr qint64 MaxBrokerMessageSize = 16 * 1024 * 1024;
 
-Settings::RegData::~RegData()
+template <typename... Args>
+QByteArray brokerMessage(BrokerMessage type, const Args&... args)
 {
-    clearConns();
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << static_cast<quint8>(type);
+    (stream << ... << args);
+    return message;
 }
 
-void Settings::RegData::clearConns() const
+/**
+ * @brief isUnderPath 键是否是路径本身或在路径的组中，路径为空时包括所有键
+ */
+bool isUnderPath(const QString& key, const QString& path)
 {
-    // 从全局表中删除
-    for (const auto id : conn_ids)
+    return path.isEmpty() || key == path || (key.startsWith(path) && key.at(path.size()) == QLatin1Char('/'));
+}
+
+/**
+ * @brief convertLike 将命令行参数、环境变量中的文本或导入的值尽量转换为默认值的类型
+ */
+QVariant convertLike(const QVariant& value, const QVariant& like)
+{
+    if (like.isValid() && value.userType() != like.userType())
     {
-        Q_ASSERT_X(
-            s_conns.contains(id),
-            Q_FUNC_INFO,
-            QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
-        );
-        s_conns.remove(id);
+        auto converted = value;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        if (converted.convert(like.metaType()))
+#else
+        if (converted.convert(like.userType()))
+#endif
+        {
+            return converted;
+        }
     }
-    // 从自己中删除
-    conn_ids.clear();
+    return value;
 }
 
-Settings::RegData* Settings::RegGroup::findData(const QString& key)
+/**
+ * @brief iniUnescapedKey 按 QSettings 的规则解码 INI 文件中的节名和键名：%XX、%UXXXX 转义，'\' 是组的分隔符
+ */
+QString iniUnescapedKey(const QString& text)
 {
-    auto [words, name] = parsePath(key);
-
-    // 组为空（全局组），如果 name 也为空会返回 dataEnd();
-    if (words.isEmpty())
+    QString key;
+    key.reserve(text.size());
+    for (int i = 0; i < text.size(); ++i)
     {
-        if (auto data_it = dataset.find({name}); data_it != dataset.end())
+        const auto ch = text.at(i);
+        if (ch == QLatin1Char('\\'))
+        {
+            key.append(QLatin1Char('/'));
+            continue;
+        }
+        if (ch == QLatin1Char('%'))
         {
-            return &(data_it.value());
+            bool ok = false;
+            const auto wide = text.size() >= i + 6 && text.at(i + 1) == QLatin1Char('U');
+            const auto code = wide ? text.mid(i + 2, 4).toUShort(&ok, 16) : text.mid(i + 1, 2).toUShort(&ok, 16);
+            if (ok && (wide || text.size() >= i + 3))
+            {
+                key.append(QChar(code));
+                i += wide ? 5 : 2;
+                continue;
+            }
         }
+        key.append(ch);
     }
-    // 否则从组中查找
-    else if (auto group = findGroup(words); group != nullptr)
+    return key;
+}
+
+/**
+ * @brief iniUnescapedValue 按 QSettings 的规则解码 INI 文件中的值：引号、反斜杠转义，引号外的逗号分隔字符串列表
+ * @return 是否是能确定解码结果的写法，续行、引号外的注释和不认识的转义都返回 false
+ */
+bool iniUnescapedValue(const QString& text, QStringList& parts)
+{
+    QString current;
+    int kept = 0;        // 引号内和转义出的字符不去掉末尾的空白
+    bool started = false; // 引号外开头的空白不属于值
+    bool quoted = false;
+    const auto finish = [&] {
+        while (current.size() > kept && current.back().isSpace())
+        {
+            current.chop(1);
+        }
+        parts.append(std::exchange(current, {}));
+        kept = 0;
+        started = false;
+    };
+    for (int i = 0; i < text.size(); ++i)
+    {
+        const auto ch = text.at(i);
+        if (ch == QLatin1Char('"'))
+        {
+            quoted = !quoted;
+            started = true;
+            kept = current.size();
+            continue;
+        }
+        if (ch == QLatin1Char('\\'))
+        {
+            if (++i == text.size())
+            {
+                return false;
+            }
+            const auto escaped = text.at(i).unicode();
+            static const QString simple = QStringLiteral("abfnrtv\"'?\\");
+            static const QString replaced = QStringLiteral("\a\b\f\n\r\t\v\"'?\\");
+            if (const auto index = simple.indexOf(text.at(i)); index >= 0)
+            {
+                current.append(replaced.at(index));
+            }
+            else if (escaped == 'x' || (escaped >= '0' && escaped <= '7'))
+            {
+                // QSettings 写出的十六进制最多 4 位，八进制最多 3 位
+                const auto hex = escaped == 'x';
+                const auto first = hex ? i + 1 : i;
+                auto end = first;
+                const auto digit = [hex](QChar c) {
+                    const auto lower = c.toLower();
+                    if (!hex)
+                    {
+                        return c >= QLatin1Char('0') && c <= QLatin1Char('7');
+                    }
+                    return (c >= QLatin1Char('0') && c <= QLatin1Char('9'))
+                           || (lower >= QLatin1Char('a') && lower <= QLatin1Char('f'));
+                };
+                while (end < text.size() && end < first + (hex ? 4 : 3) && digit(text.at(end)))
+                {
+                    ++end;
+                }
+                if (end == first)
+                {
+                    return false;
+                }
+                current.append(QChar(text.mid(first, end - first).toUShort(nullptr, hex ? 16 : 8)));
+                i = end - 1;
+            }
+            else
+            {
+                return false;
+            }
+            started = true;
+            kept = current.size();
+            continue;
+        }
+        if (!quoted && ch == QLatin1Char(','))
+        {
+            finish();
+            continue;
+        }
+        if (!quoted && ch == QLatin1Char(';'))
+        {
+            return false;
+        }
+        if (!quoted && !started && ch.isSpace())
+        {
+            continue;
+        }
+        current.append(ch);
+        started = true;
+        if (quoted)
+        {
+            kept = current.size();
+        }
+    }
+    if (quoted)
+    {
+        return false;
+    }
+    finish();
+    return true;
+}
+
+/**
+ * @brief iniStringToVariant 按 QSettings 的规则还原单个值，@ 开头的是其他类型，不认识的类型返回 false
+ */
+bool iniStringToVariant(const QString& text, QVariant& value)
+{
+    if (!text.startsWith(QLatin1Char('@')))
+    {
+        value = text;
+        return true;
+    }
+    if (text.startsWith(QLatin1String("@@")))
+    {
+        value = text.mid(1);
+        return true;
+    }
+    const auto open = text.indexOf(QLatin1Char('('));
+    if (open < 0 || !text.endsWith(QLatin1Char(')')))
+    {
+        return false;
+    }
+    const auto type = text.left(open);
+    const auto args = text.mid(open + 1, text.size() - open - 2);
+    if (type == QLatin1String("@Invalid"))
+    {
+        value = QVariant();
+        return args.isEmpty();
+    }
+    if (type == QLatin1String("@ByteArray"))
+    {
+        value = args.toLatin1();
+        return true;
+    }
+    if (type == QLatin1String("@Variant"))
+    {
+        // QSettings 写入 @Variant 时使用 Qt 4.0 的数据流格式
+        auto bytes = args.toLatin1();
+        QDataStream stream(&bytes, QIODevice::ReadOnly);
+        stream.setVersion(QDataStream::Qt_4_0);
+        stream >> value;
+        return stream.status() == QDataStream::Ok;
+    }
+
+    QVector<int> numbers;
+    for (const auto& arg : args.split(QLatin1Char(' ')))
+    {
+        bool ok = false;
+        numbers.append(arg.toInt(&ok));
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    if (type == QLatin1String("@Size") && numbers.size() == 2)
+    {
+        value = QSize(numbers.at(0), numbers.at(1));
+        return true;
+    }
+    if (type == QLatin1String("@Point") && numbers.size() == 2)
+    {
+        value = QPoint(numbers.at(0), numbers.at(1));
+        return true;
+    }
+    if (type == QLatin1String("@Rect") && numbers.size() == 4)
+    {
+        value = QRect(numbers.at(0), numbers.at(1), numbers.at(2), numbers.at(3));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief jsonFromVariant 导出 JSON 时编码值，JSON 不能表示的类型按 QSettings 的写法编码为字符串：
+ *        几何类型写为 @Size(w h)、@Point(x y)、@Rect(x y w h)，其他类型写为 @Variant(...)，@ 开头的字符串写为 @@...
+ */
+QJsonValue jsonFromVariant(const QVariant& value)
+{
+    switch (value.userType())
+    {
+    case QMetaType::QSize:
+    {
+        const auto size = value.toSize();
+        return QStringLiteral("@Size(%1 %2)").arg(size.width()).arg(size.height());
+    }
+    case QMetaType::QPoint:
+    {
+        const auto point = value.toPoint();
+        return QStringLiteral("@Point(%1 %2)").arg(point.x()).arg(point.y());
+    }
+    case QMetaType::QRect:
+    {
+        const auto rect = value.toRect();
+        return QStringLiteral("@Rect(%1 %2 %3 %4)").arg(rect.x()).arg(rect.y()).arg(rect.width()).arg(rect.height());
+    }
+    case QMetaType::QString:
+    {
+        const auto text = value.toString();
+        return text.startsWith(QLatin1Char('@')) ? QLatin1Char('@') + text : text;
+    }
+    default:
+        break;
+    }
+    auto json = QJsonValue::fromVariant(value);
+    if (json.isNull() && value.isValid() && !value.isNull())
+    {
+        QByteArray bytes;
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_4_0);
+        stream << value;
+        json = QStringLiteral("@Variant(%1)").arg(QString::fromLatin1(bytes));
+    }
+    return json;
+}
+
+/**
+ * @brief jsonToVariant 还原 jsonFromVariant 编码的值，不认识的 @ 写法保留为字符串
+ */
+QVariant jsonToVariant(const QJsonValue& json)
+{
+    QVariant value;
+    if (json.isString() && iniStringToVariant(json.toString(), value))
+    {
+        return value;
+    }
+    return json.toVariant();
+}
+} // namespace
+
+// 未启用追踪时不会构造作用域对象
+#ifdef LZL_QT_SETTINGS_TRACE
+    #define LZL_SETTINGS_TRACE_SCOPE(...) const TraceScope _lzl_trace_scope(__VA_ARGS__)
+#else
+    #define LZL_SETTINGS_TRACE_SCOPE(...) ((void)0)
+#endif
+
+// 实例构造
+/* ========================================================================== */
+
+Settings::Scope* Settings::s_instance = nullptr;
+QString Settings::s_ini_directory = {};
+QString Settings::s_ini_file_name = {};
+int Settings::s_history_capacity = 0;
+int Settings::s_parallelism = 0;
+
+Settings::Scope& Settings::instance()
+{
+    if (s_instance == nullptr)
+    {
+        static QMutex mutex;
+        QMutexLocker locker(&mutex);
+        if (s_instance == nullptr)
+        {
+            s_instance = new Scope([] {
+                if (!s_ini_file_name.isEmpty())
+                {
+                    return QDir(s_ini_directory).filePath(s_ini_file_name);
+                }
+                if (QDir::isRelativePath(CONFIG_INI))
+                {
+                    return QDir(s_ini_directory).filePath(QStringLiteral(CONFIG_INI));
+                }
+                return QStringLiteral(CONFIG_INI);
+            }());
+        }
+    }
+    return *s_instance;
+}
+
+void Settings::InitIniDirectory(const QString& directory) noexcept
+{
+    Q_ASSERT_X(
+        s_instance == nullptr,
+        Q_FUNC_INFO,
+        QStringLiteral("The function must be called before 'Settings' initialization.").toUtf8().constData()
+    );
+    s_ini_directory = directory;
+}
+
+void Settings::InitIniFilePath(const QString& file_path)
+{
+    Q_ASSERT_X(
+        s_instance == nullptr,
+        Q_FUNC_INFO,
+        QStringLiteral("The function must be called before 'Settings' initialization.").toUtf8().constData()
+    );
+    QFileInfo fileinfo(file_path);
+    Q_ASSERT_X(
+        fileinfo.suffix() == "ini", Q_FUNC_INFO, QStringLiteral("The file suffix must be 'ini'.").toUtf8().constData()
+    );
+    s_ini_file_name = fileinfo.fileName();
+    s_ini_directory = fileinfo.path();
+}
+
+void Settings::setHistoryCapacity(int capacity)
+{
+    Q_ASSERT_X(
+        capacity >= 0,
+        Q_FUNC_INFO,
+        QStringLiteral("History capacity must not be negative: %1").arg(capacity).toUtf8().constData()
+    );
+    s_history_capacity = capacity;
+}
+
+void Settings::setParallelism(int threads)
+{
+    Q_ASSERT_X(
+        threads >= 0,
+        Q_FUNC_INFO,
+        QStringLiteral("Parallelism must not be negative: %1").arg(threads).toUtf8().constData()
+    );
+    s_parallelism = threads;
+}
+
+// 注册表相关类的成员函数
+/* ========================================================================== */
+
+struct Settings::CompactValue::Box final
+{
+    QAtomicInt ref;
+    QVariant value;
+};
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+static_assert(sizeof(QString) == sizeof(void*), "Qt5 QString should be a single d-pointer");
+
+const QString* Settings::CompactValue::string() const
+{
+    return std::launder(reinterpret_cast<const QString*>(m_data.string));
+}
+#endif
+
+Settings::CompactValue::CompactValue(const QVariant& value)
+{
+    static_assert(sizeof(CompactValue) <= 16, "CompactValue should stay within two machine words");
+    static_assert(sizeof(CompactValue) <= sizeof(QVariant), "CompactValue should not be larger than QVariant");
+    m_data.bits = 0;
+    const auto fits16 = [](int v) {
+        return v >= std::numeric_limits<qint16>::min() && v <= std::numeric_limits<qint16>::max();
+    };
+    switch (value.userType())
+    {
+    case QMetaType::UnknownType:
+        return;
+    case QMetaType::Bool:
+        m_tag = Tag::Bool;
+        m_data.bits = value.toBool() ? 1 : 0;
+        return;
+    case QMetaType::Int:
+        m_tag = Tag::Int;
+        m_data.integer = value.toInt();
+        return;
+    case QMetaType::UInt:
+        m_tag = Tag::UInt;
+        m_data.bits = value.toUInt();
+        return;
+    case QMetaType::LongLong:
+        m_tag = Tag::LongLong;
+        m_data.integer = value.toLongLong();
+        return;
+    case QMetaType::ULongLong:
+        m_tag = Tag::ULongLong;
+        m_data.bits = value.toULongLong();
+        return;
+    case QMetaType::Double:
+        m_tag = Tag::Double;
+        m_data.real = value.toDouble();
+        return;
+    case QMetaType::QSize:
+    {
+        const auto size = value.toSize();
+        m_tag = Tag::Size;
+        m_data.pair[0] = size.width();
+        m_data.pair[1] = size.height();
+        return;
+    }
+    case QMetaType::QPoint:
+    {
+        const auto point = value.toPoint();
+        m_tag = Tag::Point;
+        m_data.pair[0] = point.x();
+        m_data.pair[1] = point.y();
+        return;
+    }
+    case QMetaType::QRect:
+    {
+        // 屏幕坐标通常在 16 位以内，超出时保存在堆块中
+        const auto rect = value.toRect();
+        if (fits16(rect.x()) && fits16(rect.y()) && fits16(rect.width()) && fits16(rect.height()))
+        {
+            m_tag = Tag::Rect;
+            m_data.rect[0] = static_cast<qint16>(rect.x());
+            m_data.rect[1] = static_cast<qint16>(rect.y());
+            m_data.rect[2] = static_cast<qint16>(rect.width());
+            m_data.rect[3] = static_cast<qint16>(rect.height());
+            return;
+        }
+        break;
+    }
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    case QMetaType::QString:
+        m_tag = Tag::String;
+        new (m_data.string) QString(value.toString());
+        return;
+#endif
+    default:
+        break;
+    }
+    m_tag = Tag::Boxed;
+    m_data.box = new Box{QAtomicInt(1), value};
+}
+
+Settings::CompactValue::CompactValue(const CompactValue& other) noexcept : m_data(other.m_data), m_tag(other.m_tag)
+{
+    if (m_tag == Tag::Boxed)
+    {
+        m_data.box->ref.ref();
+    }
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    else if (m_tag == Tag::String)
+    {
+        new (m_data.string) QString(*other.string());
+    }
+#endif
+}
+
+Settings::CompactValue::CompactValue(CompactValue&& other) noexcept : m_data(other.m_data), m_tag(other.m_tag)
+{
+    // QString 可以按位移动（Q_MOVABLE_TYPE），原来的值不再析构
+    other.m_tag = Tag::Invalid;
+}
+
+Settings::CompactValue& Settings::CompactValue::operator=(CompactValue other) noexcept
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_tag, other.m_tag);
+    return *this;
+}
+
+Settings::CompactValue::~CompactValue()
+{
+    if (m_tag == Tag::Boxed && !m_data.box->ref.deref())
+    {
+        delete m_data.box;
+    }
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    if (m_tag == Tag::String)
+    {
+        string()->~QString();
+    }
+#endif
+}
+
+QVariant Settings::CompactValue::toVariant() const
+{
+    switch (m_tag)
+    {
+    case Tag::Invalid:
+        return {};
+    case Tag::Bool:
+        return QVariant(m_data.bits != 0);
+    case Tag::Int:
+        return QVariant(static_cast<int>(m_data.integer));
+    case Tag::UInt:
+        return QVariant(static_cast<uint>(m_data.bits));
+    case Tag::LongLong:
+        return QVariant(static_cast<qlonglong>(m_data.integer));
+    case Tag::ULongLong:
+        return QVariant(static_cast<qulonglong>(m_data.bits));
+    case Tag::Double:
+        return QVariant(m_data.real);
+    case Tag::Size:
+        return QVariant(QSize(m_data.pair[0], m_data.pair[1]));
+    case Tag::Point:
+        return QVariant(QPoint(m_data.pair[0], m_data.pair[1]));
+    case Tag::Rect:
+        return QVariant(QRect(m_data.rect[0], m_data.rect[1], m_data.rect[2], m_data.rect[3]));
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    case Tag::String:
+        return QVariant(*string());
+#endif
+    case Tag::Boxed:
+        return m_data.box->value;
+    }
+    return {};
+}
+
+bool Settings::CompactValue::operator==(const CompactValue& other) const
+{
+    // 类型不同时按 QVariant 的规则比较（如 int 和 double）
+    if (m_tag != other.m_tag)
+    {
+        return toVariant() == other.toVariant();
+    }
+    switch (m_tag)
+    {
+    case Tag::Invalid:
+        return true;
+    case Tag::Double:
+        return m_data.real == other.m_data.real;
+    case Tag::Boxed:
+        return m_data.box == other.m_data.box || m_data.box->value == other.m_data.box->value;
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    case Tag::String:
+        return *string() == *other.string();
+#endif
+    default:
+        // 其余类型的值都规范地保存在 8 个字节中
+        return m_data.bits == other.m_data.bits;
+    }
+}
+
+void Settings::RegData::clearConns() const
+{
+    // 从全局表中删除
+    for (const auto id : conn_ids)
+    {
+        Q_ASSERT_X(
+            s_conns.contains(id),
+            Q_FUNC_INFO,
+            QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
+        );
+        s_conns.remove(id);
+    }
+    // 从自己中删除
+    conn_ids.clear();
+}
+
+std::shared_ptr<const Settings::RegData> Settings::makeRecord(
+    CompactValue default_value,
+    CheckFunction check_func,
+    bool concurrent_check,
+    std::shared_ptr<const RegData> schema
+)
+{
+    auto data = RegData{std::move(default_value), std::move(check_func)};
+    data.schema = std::move(schema);
+    data.concurrent_check = concurrent_check;
+    if (s_history_capacity > 0)
+    {
+        data.history = HistoryRing(s_history_capacity, QDateTime::currentMSecsSinceEpoch());
+    }
+    return makeNode<RegData>(std::move(data));
+}
+
+QList<Settings::HistoryEntry> Settings::HistoryRing::entries() const
+{
+    QList<HistoryEntry> entries;
+    entries.reserve(m_size);
+    for (auto i = 0; i < m_size; ++i)
+    {
+        entries.append(at(i));
+    }
+    return entries;
+}
+
+const Settings::HistoryEntry* Settings::HistoryRing::find(qint64 timestamp) const
+{
+    // 记录按时间排序，从新到旧找到第一条不晚于 timestamp 的
+    for (auto i = m_size - 1; i >= 0; --i)
+    {
+        if (const auto& entry = at(i); entry.timestamp <= timestamp)
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void Settings::HistoryRing::append(HistoryEntry&& entry)
+{
+    Q_ASSERT(isEnabled());
+    // 满了之后覆盖最旧的记录，不重新分配
+    if (m_size < m_entries.size())
+    {
+        m_entries[(m_head + m_size++) % m_entries.size()] = std::move(entry);
+    }
+    else
+    {
+        m_entries[m_head] = std::move(entry);
+        m_head = (m_head + 1) % m_entries.size();
+    }
+}
+
+std::shared_ptr<const Settings::RegData> Settings::RegGroup::findData(const QString& key) const
+{
+    auto [words, name] = parsePath(key);
+
+    // 组为空（全局组），如果 name 也为空会返回 nullptr
+    // 只使用 const 接口查找，避免快照中隐式共享的数组分离
+    if (auto group = words.isEmpty() ? this : findGroup(words); group != nullptr)
+    {
+        if (auto data = group->dataset.find(findSegment(name)); data != nullptr)
+        {
+            return *data;
+        }
+    }
+    return nullptr;
+}
+
+const Settings::RegGroup* Settings::RegGroup::findGroup(const QString& dir) const
+{
+    return findGroup(detachPath(dir));
+}
+
+const Settings::RegGroup* Settings::RegGroup::findGroup(const QStringList& words) const
+{
+    // 从根节点开始查找
+    auto group = this;
+    for (const auto& word : words)
+    {
+        // 没有驻留过的段返回 0，一定找不到
+        auto sub_group = group->groupset.find(findSegment(word));
+        if (sub_group == nullptr)
+        {
+            return nullptr;
+        }
+        group = sub_group->get();
+    }
+    return group; // group 是最后一个有效节点
+}
+
+void Settings::RegGroup::insertData(
+    const QString& key, const QVariant& default_value, CheckFunction check_func, bool concurrent_check
+)
+{
+    Q_ASSERT(!key.isEmpty());
+
+    // 查找组
+    auto [words, name] = parsePath(key);
+    auto group = this;
+    for (const auto& word : std::as_const(words))
+    {
+        group = &(group->detachGroup(internSegment(word)));
+    }
+
+    const auto name_id = internSegment(name);
+    Q_ASSERT_X(
+        !group->dataset.contains(name_id),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting registration `record` already exists: %1").arg(key).toUtf8().constData()
+    );
+    Q_ASSERT_X(
+        check_func(default_value),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting default value check failed: %1").arg(key).toUtf8().constData()
+    );
+
+    group->dataset[name_id] = makeRecord(default_value, std::move(check_func), concurrent_check);
+}
+
+std::shared_ptr<const Settings::RegData> Settings::RegGroup::removeData(const QString& key)
+{
+    Q_ASSERT(!key.isEmpty());
+
+    // 查找组
+    QList<RegGroup*> groups = {this};
+    auto [words, name] = parsePath(key);
+    for (const auto& word : std::as_const(words))
+    {
+        // 只分离已经存在的组，路径不存在时不能创建空节点
+        const auto word_id = findSegment(word);
+        if (!groups.last()->groupset.contains(word_id))
+        {
+            Q_ASSERT_X(
+                false,
+                Q_FUNC_INFO,
+                QStringLiteral("Setting registration `record` not found: %1").arg(key).toUtf8().constData()
+            );
+            return nullptr;
+        }
+        groups.append(&(groups.last()->detachGroup(word_id)));
+    }
+
+    auto group = groups.takeLast();
+    const auto name_id = findSegment(name);
+    Q_ASSERT_X(
+        group->dataset.contains(name_id),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting registration `record` not found: %1").arg(key).toUtf8().constData()
+    );
+    if (!group->dataset.contains(name_id))
+    {
+        return nullptr;
+    }
+
+    // 删除数据
+    auto data = group->dataset.take(name_id);
+
+    // 清除空节点
+    while (!groups.isEmpty() && group->dataset.isEmpty() && group->groupset.isEmpty())
+    {
+        Q_ASSERT(words.size() == groups.size());
+        group = groups.takeLast();
+        group->groupset.remove(findSegment(words.takeLast()));
+    }
+    return data;
+}
+
+std::shared_ptr<const Settings::RegGroup> Settings::RegGroup::removeGroup(const QString& dir)
+{
+    Q_ASSERT(!dir.isEmpty());
+
+    // 查找组
+    QList<RegGroup*> groups = {this};
+    auto [pre_words, group_name] = parsePath(dir);
+    for (const auto& word : std::as_const(pre_words))
+    {
+        const auto word_id = findSegment(word);
+        if (!groups.last()->groupset.contains(word_id))
+        {
+            Q_ASSERT_X(
+                false,
+                Q_FUNC_INFO,
+                QStringLiteral("Setting registration `group` not found: %1").arg(dir).toUtf8().constData()
+            );
+            return nullptr;
+        }
+        groups.append(&(groups.last()->detachGroup(word_id)));
+    }
+
+    auto group = groups.takeLast();
+    const auto group_id = findSegment(group_name);
+    Q_ASSERT_X(
+        group->groupset.contains(group_id),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting registration `group` not found: %1").arg(dir).toUtf8().constData()
+    );
+    if (!group->groupset.contains(group_id))
+    {
+        return nullptr;
+    }
+
+    // 删除组
+    auto removed = group->groupset.take(group_id);
+
+    // 清除空节点
+    while (!groups.isEmpty() && group->dataset.isEmpty() && group->groupset.isEmpty())
+    {
+        group = groups.takeLast();
+        group->groupset.remove(findSegment(pre_words.takeLast()));
+    }
+    return removed;
+}
+
+Settings::RegGroup& Settings::RegGroup::detachGroup(SegmentId word)
+{
+    // 子组可能被旧快照共享，复制后替换（复制只增加子节点数组的引用计数）
+    auto& slot = groupset[word];
+    auto group = slot ? makeNode<RegGroup>(*slot) : makeNode<RegGroup>();
+    slot = group;
+    return *group;
+}
+
+void Settings::RegGroup::clearConns() const
+{
+    for (auto i = 0; i < dataset.size(); ++i)
+    {
+        dataset.valueAt(i)->clearConns();
+    }
+    for (auto i = 0; i < groupset.size(); ++i)
+    {
+        groupset.valueAt(i)->clearConns();
+    }
+}
+
+QStringList Settings::RegGroup::keys(const QString& dir) const
+{
+    const auto prefix = dir.isEmpty() ? QString() : dir + QLatin1Char('/');
+    QStringList result;
+    for (auto i = 0; i < dataset.size(); ++i)
+    {
+        result.append(prefix + segmentName(dataset.keyAt(i)));
+    }
+    for (auto i = 0; i < groupset.size(); ++i)
+    {
+        // 名为 `*` 的组是实例的模板，不是真正的键
+        if (const auto name = segmentName(groupset.keyAt(i)); name != QLatin1String("*"))
+        {
+            result.append(groupset.valueAt(i)->keys(prefix + name));
+        }
+    }
+    return result;
+}
+
+// 注册表相关类的静态
+/* ========================================================================== */
+
+QStringList Settings::RegGroup::detachPath(const QString& path)
+{
+    // 如果 path 为空，返回空列表；逐个字符扫描分隔符，跳过空段
+    QStringList words;
+    decltype(path.size()) begin = 0;
+    for (decltype(path.size()) i = 0; i <= path.size(); ++i)
+    {
+        if (i < path.size() && path.at(i) != QLatin1Char('/') && path.at(i) != QLatin1Char('\\'))
+        {
+            continue;
+        }
+        if (i > begin)
+        {
+            words.append(path.mid(begin, i - begin));
+        }
+        begin = i + 1;
+    }
+    return words;
+}
+
+Settings::RegGroup::ParsedPathPair Settings::RegGroup::parsePath(const QString& path)
+{
+    // 如果 path 为空，返回空列表和空字符串
+    auto words = detachPath(path);
+    auto name = words.isEmpty() ? QString() : words.takeLast();
+    return {words, name};
+}
+
+QString Settings::RegGroup::normalizePath(const QString& path)
+{
+    // 绝大多数路径已经是规范的，只需要扫描一遍，避免分割和拼接
+    auto normalized = !path.startsWith(QLatin1Char('/')) && !path.endsWith(QLatin1Char('/'));
+    for (decltype(path.size()) i = 0; normalized && i < path.size(); ++i)
+    {
+        const auto c = path.at(i);
+        // 结尾不是 '/'，因此 c 为 '/' 时 i + 1 不会越界
+        normalized = c != QLatin1Char('\\') && !(c == QLatin1Char('/') && path.at(i + 1) == QLatin1Char('/'));
+    }
+    return normalized ? path : detachPath(path).join(QLatin1Char('/'));
+}
+
+Settings::SegmentId Settings::internSegment(const QString& word)
+{
+    return SegmentTable::instance().intern(word);
+}
+
+Settings::SegmentId Settings::findSegment(const QString& word)
+{
+    return SegmentTable::instance().find(word);
+}
+
+QString Settings::segmentName(SegmentId id)
+{
+    return SegmentTable::instance().name(id);
+}
+
+// 主类的静态（对外接口）函数实现
+/* ========================================================================== */
+
+void Settings::disconnectReadValue(ConnId id)
+{
+    Q_ASSERT(!id.isNull());
+    Q_ASSERT_X(
+        s_conns.contains(id),
+        Q_FUNC_INFO,
+        QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
+    );
+    s_conns.take(id).disconnect();
+}
+
+void Settings::disconnectAllSettingsReadValues()
+{
+    // 先取出整个表再逐个解绑，解绑时即使再次修改表也不会使遍历失效
+    const auto conns = std::exchange(s_conns, {});
+    for (auto it = conns.cbegin(); it != conns.cend(); ++it)
+    {
+        it.value().disconnect();
+    }
+}
+
+void Settings::emitReadValue(ConnId id)
+{
+    emitReadValues({id});
+}
+
+void Settings::emitReadValues(const QList<ConnId>& ids)
+{
+    for (const auto id : ids)
+    {
+        Q_ASSERT_X(
+            s_conns.contains(id),
+            Q_FUNC_INFO,
+            QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
+        );
+        // 已经在等待中的事件不重复加入，执行时会读取最新值
+        if (!s_emit_pending.contains(id))
+        {
+            s_emit_pending.insert(id);
+            s_emit_queue.append(id);
+        }
+    }
+    // 如果正在执行（即在回调中触发），交给外层继续执行
+    if (!s_emit_draining)
+    {
+        drainEmits();
+    }
+}
+
+void Settings::emitAllSettingsReadValues()
+{
+    emitReadValues(s_conns.keys());
+}
+
+void Settings::setConnPriority(ConnId id, int priority)
+{
+    Q_ASSERT_X(
+        s_conns.contains(id),
+        Q_FUNC_INFO,
+        QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
+    );
+    if (auto it = s_conns.find(id); it != s_conns.end())
+    {
+        it->priority = priority;
+    }
+}
+
+void Settings::setDeferredEmitBudget(int msecs)
+{
+    Q_ASSERT_X(
+        msecs >= 0,
+        Q_FUNC_INFO,
+        QStringLiteral("Deferred emit budget must not be negative: %1").arg(msecs).toUtf8().constData()
+    );
+    s_deferred_budget = msecs;
+}
+
+Settings::Stats Settings::stats()
+{
+    Stats stats;
+#ifdef LZL_QT_SETTINGS_STATS
+    const auto regedit = instance().registry();
+    collectStats(regedit.get(), {}, stats);
+#endif
+    return stats;
+}
+
+QByteArray Settings::dumpStats()
+{
+    const auto snapshot = stats();
+
+    QJsonObject keys;
+    for (auto it = snapshot.keys.cbegin(); it != snapshot.keys.cend(); ++it)
+    {
+        QJsonObject key_stats;
+        key_stats.insert(QStringLiteral("reads"), static_cast<qint64>(it->reads));
+        key_stats.insert(QStringLiteral("writes"), static_cast<qint64>(it->writes));
+        key_stats.insert(QStringLiteral("check_failures"), static_cast<qint64>(it->check_failures));
+        key_stats.insert(QStringLiteral("cache_hits"), static_cast<qint64>(it->cache_hits));
+        key_stats.insert(QStringLiteral("emits"), static_cast<qint64>(it->emits));
+        keys.insert(it.key(), key_stats);
+    }
+
+    QJsonObject conns;
+    for (auto it = snapshot.conns.cbegin(); it != snapshot.conns.cend(); ++it)
+    {
+        QJsonArray histogram;
+        for (const auto count : it->latency_histogram)
+        {
+            histogram.append(static_cast<qint64>(count));
+        }
+        QJsonObject conn_stats;
+        conn_stats.insert(QStringLiteral("key"), it->key);
+        conn_stats.insert(QStringLiteral("calls"), static_cast<qint64>(it->calls));
+        conn_stats.insert(QStringLiteral("total_ns"), it->total_ns);
+        conn_stats.insert(QStringLiteral("max_ns"), it->max_ns);
+        conn_stats.insert(QStringLiteral("latency_histogram_us"), histogram);
+        conns.insert(QString::number(static_cast<std::size_t>(it.key())), conn_stats);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("enabled"), statsEnabled());
+    root.insert(QStringLiteral("keys"), keys);
+    root.insert(QStringLiteral("conns"), conns);
+    return QJsonDocument(root).toJson();
+}
+
+void Settings::resetStats()
+{
+#ifdef LZL_QT_SETTINGS_STATS
+    resetStats(instance().registry().get());
+    for (auto& conn : s_conns)
+    {
+        conn.stats = {};
+    }
+#endif
+}
+
+QStringList Settings::checkIntegrity()
+{
+    QStringList problems;
+    instance().checkIntegrity(problems);
+    return problems;
+}
+
+void Settings::startTrace(int capacity)
+{
+#ifdef LZL_QT_SETTINGS_TRACE
+    Q_ASSERT(capacity > 0);
+    auto& state = traceState();
+    state.active = true;
+    state.capacity = capacity;
+    state.dropped = 0;
+    state.events.clear();
+    state.clock.start();
+#else
+    Q_UNUSED(capacity);
+#endif
+}
+
+void Settings::stopTrace()
+{
+#ifdef LZL_QT_SETTINGS_TRACE
+    traceState().active = false;
+#endif
+}
+
+QByteArray Settings::dumpTrace()
+{
+    QJsonArray trace_events;
+    QJsonObject other_data;
+#ifdef LZL_QT_SETTINGS_TRACE
+    const auto& state = traceState();
+    const auto pid = QCoreApplication::applicationPid();
+    const auto tid = static_cast<qint64>(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+    for (const auto& event : state.events)
+    {
+        QJsonObject args;
+        args.insert(QStringLiteral("key"), event.key);
+        args.insert(QStringLiteral("conn_id"), static_cast<qint64>(event.conn_id));
+        args.insert(QStringLiteral("depth"), event.depth);
+
+        QJsonObject trace_event;
+        trace_event.insert(QStringLiteral("name"), QString::fromLatin1(event.name));
+        trace_event.insert(QStringLiteral("cat"), QStringLiteral("lzl.settings"));
+        trace_event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+        trace_event.insert(QStringLiteral("ts"), event.begin_ns / 1000.0);
+        trace_event.insert(QStringLiteral("dur"), event.duration_ns / 1000.0);
+        trace_event.insert(QStringLiteral("pid"), pid);
+        trace_event.insert(QStringLiteral("tid"), tid);
+        trace_event.insert(QStringLiteral("args"), args);
+        trace_events.append(trace_event);
+    }
+    other_data.insert(QStringLiteral("dropped"), static_cast<qint64>(state.dropped));
+#endif
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), trace_events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ns"));
+    root.insert(QStringLiteral("otherData"), other_data);
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+// 多进程共享模式
+/* ========================================================================== */
+
+/**
+ * @brief SharedState 多进程共享模式的状态
+ * @note 共享内存的锁同时串行化各个进程对设置文件的写入；进程崩溃时系统会释放它持有的锁
+ */
+struct Settings::Scope::SharedState final
+{
+#if QT_CONFIG(sharedmemory)
+    QSharedMemory memory;
+#endif
+    quint64 seen = 0; // 上次检查时的计数
+    int depth = 0;    // beginSharedWrite 的嵌套深度
+    QStringList pending_keys;
+    bool pending_all = false;
+
+    [[nodiscard]] bool attach(const QString& file_path);
+    void lock();
+    void unlock();
+    [[nodiscard]] quint64 counter();
+    // 下面的函数需要在加锁时调用
+    void publish(const QStringList& keys, bool all);
+    void collect(QSet<quint32>& hashes, bool& all);
+
+private:
+#if QT_CONFIG(sharedmemory)
+    [[nodiscard]] SharedHeader* header() { return static_cast<SharedHeader*>(memory.data()); }
+    [[nodiscard]] SharedSlot* table() { return reinterpret_cast<SharedSlot*>(header() + 1); }
+    // 键所在的槽位，没有时占用空槽位，槽位用尽时返回空
+    [[nodiscard]] SharedSlot* slot(quint32 hash);
+#endif
+};
+
+#if QT_CONFIG(sharedmemory)
+bool Settings::Scope::SharedState::attach(const QString& file_path)
+{
+    // 同一个文件的所有进程使用同一段共享内存
+    const auto path_hash = QCryptographicHash::hash(
+        QFileInfo(file_path).absoluteFilePath().toUtf8(), QCryptographicHash::Sha1
+    );
+    const auto name = QStringLiteral("lzl-qt-settings-") + QString::fromLatin1(path_hash.toHex());
+    #if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    memory.setNativeKey(QSharedMemory::legacyNativeKey(name));
+    #else
+    memory.setKey(name);
+    #endif
+
+    constexpr auto size = static_cast<qsizetype>(sizeof(SharedHeader) + sizeof(SharedSlot) * SharedSlotCount);
+    if (!memory.attach() && !memory.create(size)
+        && !(memory.error() == QSharedMemory::AlreadyExists && memory.attach()))
+    {
+        qWarning("lzl::utils::Settings: cannot attach shared memory: %s", qUtf8Printable(memory.errorString()));
+        return false;
+    }
+    if (memory.size() < size)
+    {
+        qWarning("lzl::utils::Settings: shared memory is too small: %s", qUtf8Printable(file_path));
+        memory.detach();
+        return false;
+    }
+
+    // 新创建的共享内存内容为 0，由第一个加锁的进程（通常是创建它的进程）在其中构造文件头，
+    // 原子量只有构造之后才能使用；之后连接的进程看到的魔数不为 0，不会重复构造
+    lock();
+    auto head = header();
+    if (head->magic == 0)
+    {
+        head = new (memory.data()) SharedHeader;
+    }
+    const auto valid = head->magic == SharedMagic && head->version == SharedVersion;
+    seen = head->counter.load(std::memory_order_relaxed);
+    unlock();
+    if (!valid)
+    {
+        qWarning("lzl::utils::Settings: shared memory has an incompatible format: %s", qUtf8Printable(file_path));
+        memory.detach();
+    }
+    return valid;
+}
+
+void Settings::Scope::SharedState::lock()
+{
+    memory.lock();
+}
+
+void Settings::Scope::SharedState::unlock()
+{
+    memory.unlock();
+}
+
+quint64 Settings::Scope::SharedState::counter()
+{
+    return header()->counter.load(std::memory_order_acquire);
+}
+
+void Settings::Scope::SharedState::publish(const QStringList& keys, bool all)
+{
+    auto head = header();
+    const auto counter = head->counter.load(std::memory_order_relaxed) + 1;
+    for (auto i = 0; !all && i < keys.size(); ++i)
+    {
+        if (auto entry = slot(sharedKeyHash(keys.at(i))); entry != nullptr)
+        {
+            entry->counter = counter;
+        }
+        else
+        {
+            all = true;
+        }
+    }
+    if (all)
+    {
+        head->reload_counter = counter;
+    }
+    head->counter.store(counter, std::memory_order_release);
+    // 上次检查之后没有其他进程修改时，不需要重新读取自己的修改
+    if (seen + 1 == counter)
+    {
+        seen = counter;
+    }
+}
+
+void Settings::Scope::SharedState::collect(QSet<quint32>& hashes, bool& all)
+{
+    auto head = header();
+    const auto counter = head->counter.load(std::memory_order_relaxed);
+    all = head->reload_counter > seen;
+    for (quint32 i = 0; !all && i < SharedSlotCount; ++i)
+    {
+        if (const auto& entry = table()[i]; entry.counter > seen)
+        {
+            hashes.insert(entry.hash);
+        }
+    }
+    seen = counter;
+}
+
+SharedSlot* Settings::Scope::SharedState::slot(quint32 hash)
+{
+    auto entries = table();
+    for (quint32 i = 0, index = hash % SharedSlotCount; i < SharedSlotCount; ++i, index = (index + 1) % SharedSlotCount)
+    {
+        if (entries[index].hash == 0)
+        {
+            entries[index].hash = hash;
+        }
+        if (entries[index].hash == hash)
+        {
+            return &entries[index];
+        }
+    }
+    return nullptr;
+}
+#else
+bool Settings::Scope::SharedState::attach(const QString& file_path)
+{
+    Q_UNUSED(file_path);
+    qWarning("lzl::utils::Settings: shared memory is not supported on this platform.");
+    return false;
+}
+
+// 无法连接时不会创建共享模式的状态，下面的函数不会被调用
+void Settings::Scope::SharedState::lock() {}
+void Settings::Scope::SharedState::unlock() {}
+quint64 Settings::Scope::SharedState::counter()
+{
+    return seen;
+}
+void Settings::Scope::SharedState::publish(const QStringList&, bool) {}
+void Settings::Scope::SharedState::collect(QSet<quint32>&, bool&) {}
+#endif
+
+// 本地设置代理
+/* ========================================================================== */
+
+/**
+ * @brief BrokerClient 与本地设置代理的连接，以及代理中所有值的副本
+ * @note 套接字延迟删除，回调中断开代理时正在处理的信号依然安全
+ */
+struct Settings::Scope::BrokerClient final
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    QLocalSocket* socket = new QLocalSocket;
+
+    ~BrokerClient()
+    {
+        socket->disconnect();
+        socket->deleteLater();
+    }
+#endif
+    QVariantHash values;
+    bool ready = false; // 是否已经收到所有值
+
+    // 断开时不发送并返回 false，调用者不应该只在本地应用修改
+    bool send(const QByteArray& message)
+    {
+#ifdef LZL_QT_SETTINGS_BROKER
+        if (socket->state() != QLocalSocket::ConnectedState)
+        {
+            qWarning("lzl::utils::Settings: broker is disconnected, the change is dropped.");
+            return false;
+        }
+        socket->write(message);
+        socket->flush();
+        return true;
+#else
+        Q_UNUSED(message);
+        return false;
+#endif
+    }
+};
+
+#ifdef LZL_QT_SETTINGS_BROKER
+struct Settings::Broker::State final
+{
+    explicit State(const QString& file_path) : settings(file_path, QSettings::IniFormat)
+    {
+        // 只解析一次，之后所有客户端都从内存中读取
+        for (const auto& key : settings.allKeys())
+        {
+            values.insert(key, settings.value(key));
+        }
+        QObject::connect(&server, &QLocalServer::newConnection, &server, [this] { accept(); });
+    }
+
+    QSettings settings;
+    QVariantHash values;
+    QLocalServer server;
+    QList<QLocalSocket*> clients;
+
+    void accept();
+    void read(QLocalSocket* client);
+    void broadcast(const QLocalSocket* sender, const QByteArray& message);
+};
+
+void Settings::Broker::State::accept()
+{
+    while (auto client = server.nextPendingConnection())
+    {
+        clients.append(client);
+        QObject::connect(client, &QLocalSocket::readyRead, client, [this, client] { read(client); });
+        QObject::connect(client, &QLocalSocket::disconnected, client, [this, client] {
+            clients.removeOne(client);
+            client->deleteLater();
+        });
+    }
+}
+
+void Settings::Broker::State::read(QLocalSocket* client)
+{
+    QDataStream stream(client);
+    stream.setVersion(QDataStream::Qt_5_12);
+    // 一次读取的所有修改作为一批，先写回文件再推送，其他客户端断开代理后从文件中读到的也是新值
+    QList<QByteArray> pushes;
+    const auto guard = qScopeGuard([this, client, &pushes] {
+        if (pushes.isEmpty())
+        {
+            return;
+        }
+        settings.sync();
+        for (const auto& message : std::as_const(pushes))
+        {
+            broadcast(client, message);
+        }
+    });
+    while (true)
+    {
+        stream.startTransaction();
+        quint8 type = 0;
+        QStringList paths;
+        QVariantHash changed;
+        stream >> type;
+        switch (static_cast<BrokerMessage>(type))
+        {
+        case BrokerMessage::Read:
+        case BrokerMessage::Remove:
+            stream >> paths;
+            break;
+        case BrokerMessage::Write:
+            stream >> changed;
+            break;
+        default:
+            // 类型不完整时等待更多数据，否则是无法识别的消息
+            if (stream.status() == QDataStream::Ok)
+            {
+                qWarning("lzl::utils::Settings: broker received an unknown message, client dropped.");
+                stream.abortTransaction();
+                client->abort();
+                return;
+            }
+            break;
+        }
+        if (!stream.commitTransaction())
+        {
+            // 不完整的消息等待更多数据，但不能超过最大长度；其他错误是损坏的消息
+            if (stream.status() != QDataStream::ReadPastEnd || client->bytesAvailable() > MaxBrokerMessageSize)
+            {
+                qWarning("lzl::utils::Settings: broker received a corrupt or oversized message, client dropped.");
+                client->abort();
+            }
+            return;
+        }
+
+        if (type == static_cast<quint8>(BrokerMessage::Read))
+        {
+            QVariantHash reply;
+            if (paths.isEmpty())
+            {
+                reply = values;
+            }
+            for (const auto& key : std::as_const(paths))
+            {
+                if (auto it = values.constFind(key); it != values.cend())
+                {
+                    reply.insert(key, *it);
+                }
+            }
+            client->write(brokerMessage(BrokerMessage::Values, reply));
+        }
+        else if (type == static_cast<quint8>(BrokerMessage::Write))
+        {
+            for (auto it = changed.cbegin(); it != changed.cend(); ++it)
+            {
+                values.insert(it.key(), it.value());
+                settings.setValue(it.key(), it.value());
+            }
+            pushes.append(brokerMessage(BrokerMessage::Changed, changed, QStringList()));
+        }
+        else
+        {
+            for (const auto& path : std::as_const(paths))
+            {
+                for (auto it = values.begin(); it != values.end();)
+                {
+                    it = isUnderPath(it.key(), path) ? values.erase(it) : std::next(it);
+                }
+                settings.remove(path);
+            }
+            pushes.append(brokerMessage(BrokerMessage::Changed, QVariantHash(), paths));
+        }
+    }
+}
+
+void Settings::Broker::State::broadcast(const QLocalSocket* sender, const QByteArray& message)
+{
+    for (auto client : std::as_const(clients))
+    {
+        if (client != sender)
+        {
+            client->write(message);
+        }
+    }
+}
+#else
+struct Settings::Broker::State final
+{
+    explicit State(const QString& file_path) { Q_UNUSED(file_path); }
+};
+#endif
+
+Settings::Broker::Broker(const QString& file_path) : m_state(std::make_unique<State>(file_path)) {}
+
+Settings::Broker::~Broker()
+{
+    close();
+}
+
+bool Settings::Broker::listen(const QString& server_name)
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    // 上次异常退出可能留下了同名的套接字文件
+    QLocalServer::removeServer(server_name);
+    if (!m_state->server.listen(server_name))
+    {
+        qWarning(
+            "lzl::utils::Settings: broker cannot listen on %s: %s",
+            qUtf8Printable(server_name),
+            qUtf8Printable(m_state->server.errorString())
+        );
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(server_name);
+    qWarning("lzl::utils::Settings: broker is not compiled, enable LZL_QT_SETTINGS_ENABLE_BROKER.");
+    return false;
+#endif
+}
+
+void Settings::Broker::close()
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    m_state->server.close();
+    for (auto client : std::exchange(m_state->clients, {}))
+    {
+        client->disconnect();
+        client->disconnectFromServer();
+        client->deleteLater();
+    }
+    m_state->settings.sync();
+#endif
+}
+
+bool Settings::Broker::isListening() const
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    return m_state->server.isListening();
+#else
+    return false;
+#endif
+}
+
+int Settings::Broker::clientCount() const
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    return static_cast<int>(m_state->clients.size());
+#else
+    return 0;
+#endif
+}
+
+// 设置文件的只读解析
+/* ========================================================================== */
+
+/**
+ * @brief IniFile 只读阶段的设置文件：一次解析出所有键，读取时再按注册的默认值转换类型
+ * @note 只接受 QSettings 会写出的写法，遇到不能确定结果的写法时解析失败，作用域改用 QSettings 读取，
+ *       因此读到的值和 QSettings 相同；写入总是通过 QSettings，打开 QSettings 后丢弃解析结果
+ */
+struct Settings::Scope::IniFile final
+{
+    QHash<QString, QVariant> values; // 字符串、字符串列表或 @ 开头的类型还原出的值
+
+    // 不需要 QObject，可以在工作线程中解析；文件不存在时和 QSettings 一样是空的，解析失败返回空指针
+    [[nodiscard]] static std::unique_ptr<IniFile> parse(const QString& file_name);
+};
+
+std::unique_ptr<Settings::Scope::IniFile> Settings::Scope::IniFile::parse(const QString& file_name)
+{
+    auto ini = std::make_unique<IniFile>();
+    QFile file(file_name);
+    if (!file.exists())
+    {
+        return ini;
+    }
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return nullptr;
+    }
+    // Qt 6 的 QSettings 按 UTF-8 读取并跳过 BOM，Qt 5 未设置编码时按 Latin-1 读取
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    auto data = file.readAll();
+    if (data.startsWith("\xef\xbb\xbf"))
+    {
+        data.remove(0, 3);
+    }
+    const auto text = QString::fromUtf8(data);
+#else
+    const auto text = QString::fromLatin1(file.readAll());
+#endif
+
+    const auto is_typed = [](const QString& part) { return part.startsWith(QLatin1Char('@')); };
+    QString section;
+    for (const auto& raw_line : text.split(QLatin1Char('\n')))
+    {
+        const auto line = raw_line.trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char(';')))
+        {
+            continue;
+        }
+        if (line.startsWith(QLatin1Char('[')))
+        {
+            if (!line.endsWith(QLatin1Char(']')))
+            {
+                return nullptr;
+            }
+            // [General] 中是没有组的键，名为 General 的组写作 [%General]
+            const auto name = line.mid(1, line.size() - 2).trimmed();
+            section = name == QLatin1String("General")    ? QString()
+                      : name == QLatin1String("%General") ? QStringLiteral("General")
+                                                          : iniUnescapedKey(name);
+            continue;
+        }
+
+        const auto index = line.indexOf(QLatin1Char('='));
+        if (index <= 0 || line.startsWith(QLatin1Char('#')))
+        {
+            return nullptr;
+        }
+        QStringList parts;
+        QVariant value;
+        if (!iniUnescapedValue(line.mid(index + 1), parts))
+        {
+            return nullptr;
+        }
+        if (parts.size() == 1)
+        {
+            if (!iniStringToVariant(parts.first(), value))
+            {
+                return nullptr;
+            }
+        }
+        else if (std::any_of(parts.cbegin(), parts.cend(), is_typed))
+        {
+            // QSettings 会把列表中 @ 开头的元素还原为其他类型
+            return nullptr;
+        }
+        else
+        {
+            value = parts;
+        }
+        const auto key = iniUnescapedKey(line.left(index).trimmed());
+        ini->values.insert(section.isEmpty() ? key : section + QLatin1Char('/') + key, value);
+    }
+    return ini;
+}
+
+// 异步读取
+/* ========================================================================== */
+
+/**
+ * @brief AsyncLoad 异步读取的状态：正在加载的工作线程和等待中的读取
+ * @note context 在作用域的线程中接收加载完成，作用域析构后不会再收到；析构时等待工作线程结束
+ */
+struct Settings::Scope::AsyncLoad final
+{
+    QObject context;
+    QThread* thread = nullptr;
+    QList<QPair<QStringList, std::function<void(const QVariantHash&)>>> reads;
+
+    ~AsyncLoad()
+    {
+        if (thread != nullptr)
+        {
+            thread->wait();
+        }
+        // 作用域析构时还在等待的读取以空结果完成，而不是永远不完成
+        for (const auto& read : std::as_const(reads))
+        {
+            read.second({});
+        }
+    }
+};
+
+// 作用域的成员函数
+/* ========================================================================== */
+
+Settings::Scope::Scope(const QString& file_path, Scope* parent)
+    : m_parent(parent), m_regedit(std::make_shared<const RegGroup>()), m_file_name(file_path)
+{
+    if (m_parent != nullptr)
+    {
+        m_parent->m_children.append(this);
+    }
+}
+
+Settings::Scope::~Scope()
+{
+    Q_ASSERT_X(
+        m_children.isEmpty(),
+        Q_FUNC_INFO,
+        QStringLiteral("Child scopes must be destroyed before their parent: %1").arg(fileName()).toUtf8().constData()
+    );
+    // 发送还没有发送的写入
+    detachBroker();
+    // 解绑通过自己绑定的读取事件，它们可能在父作用域的注册表中
+    for (auto it = s_conns.begin(); it != s_conns.end();)
+    {
+        if (it->scope == this)
+        {
+            it->disconnect();
+            it = s_conns.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if (m_parent != nullptr)
+    {
+        m_parent->m_children.removeOne(this);
+    }
+}
+
+void Settings::Scope::sync()
+{
+    LZL_SETTINGS_TRACE_SCOPE("sync", fileName());
+    if (m_q_settings)
+    {
+        m_q_settings->sync();
+    }
+    // 只读阶段没有需要写回的修改，丢弃解析结果，下次读取时重新解析
+    m_ini.reset();
+    if (m_system_settings)
+    {
+        m_system_settings->sync();
+    }
+    // 同步时可能读入了其他进程的修改
+    invalidatePath({});
+}
+
+void Settings::Scope::reset()
+{
+    beginSharedWrite();
+    clearUserValues();
+    endSharedWrite({}, true);
+    invalidatePath({});
+}
+
+void Settings::Scope::reset(const QString& path)
+{
+    const auto normalized = RegGroup::normalizePath(path);
+    beginSharedWrite();
+    removeUserValue(normalized);
+    endSharedWrite(containsKey(normalized) ? QStringList{normalized} : groupKeys(normalized));
+    invalidatePath(normalized);
+}
+
+bool Settings::Scope::containsGroup(const QString& dir)
+{
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (scope->registry()->containsGroup(dir))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Settings::Scope::registerSetting(
+    const QString& key, const QVariant& default_value, CheckFunction check_func, bool concurrent_check
+)
+{
+    {
+        // 复制快照只增加引用计数
+        QMutexLocker locker(&m_regedit_mutex);
+        auto regedit = *registry();
+        regedit.insertData(key, default_value, std::move(check_func), concurrent_check);
+        publishRegistry(std::move(regedit));
+    }
+    // 可能覆盖了父作用域中的同名键
+    invalidatePath({});
+}
+
+void Settings::Scope::deRegisterSettingKey(const QString& key)
+{
+    std::shared_ptr<const RegData> data;
+    {
+        QMutexLocker locker(&m_regedit_mutex);
+        auto regedit = *registry();
+        data = regedit.removeData(key);
+        publishRegistry(std::move(regedit));
+    }
+    invalidatePath({});
+    if (data)
+    {
+        data->clearConns();
+    }
+    dropInstances(RegGroup::normalizePath(key));
+}
+
+void Settings::Scope::deRegisterSettingGroup(const QString& dir)
+{
+    std::shared_ptr<const RegGroup> group;
+    {
+        QMutexLocker locker(&m_regedit_mutex);
+        auto regedit = *registry();
+        group = regedit.removeGroup(dir);
+        publishRegistry(std::move(regedit));
+    }
+    invalidatePath({});
+    if (group)
+    {
+        group->clearConns();
+    }
+    dropInstances(RegGroup::normalizePath(dir));
+}
+
+void Settings::Scope::deRegisterAllSettings()
+{
+    std::shared_ptr<const RegGroup> regedit;
+    {
+        QMutexLocker locker(&m_regedit_mutex);
+        regedit = registry();
+        publishRegistry({});
+    }
+    invalidatePath({});
+    regedit->clearConns();
+    dropInstances({});
+}
+
+void Settings::Scope::registerInstance(const QString& dir, const QString& id, const QVariantHash& defaults)
+{
+    Q_ASSERT(!id.isEmpty() && !id.contains(QLatin1Char('/')) && !id.contains(QLatin1Char('\\')));
+    const auto path = RegGroup::normalizePath(dir);
+    Q_ASSERT_X(
+        containsGroup(path.isEmpty() ? QStringLiteral("*") : path + QStringLiteral("/*")),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting template `group` not found: %1").arg(path).toUtf8().constData()
+    );
+    Q_ASSERT_X(
+        !containsInstance(path, id),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting instance already exists: %1/%2").arg(path, id).toUtf8().constData()
+    );
+#ifndef QT_NO_DEBUG
+    const auto templ_dir = path.isEmpty() ? QStringLiteral("*/") : path + QStringLiteral("/*/");
+    for (auto it = defaults.cbegin(); it != defaults.cend(); ++it)
+    {
+        const auto templ = findData(templ_dir + it.key());
+        Q_ASSERT_X(
+            templ != nullptr && templ->check(it.value()),
+            Q_FUNC_INFO,
+            QStringLiteral("Setting instance default value check failed: %1/%2/%3")
+                .arg(path, id, it.key())
+                .toUtf8()
+                .constData()
+        );
+    }
+#endif
+    // 键的记录在绑定事件或记录历史时才创建；注册之前这些键不存在，不可能被缓存，因此不需要失效缓存
+    m_instances[path].insert(id, {defaults, {}});
+}
+
+void Settings::Scope::deRegisterInstance(const QString& dir, const QString& id)
+{
+    const auto path = RegGroup::normalizePath(dir);
+    auto group = m_instances.find(path);
+    Q_ASSERT_X(
+        group != m_instances.end() && group->contains(id),
+        Q_FUNC_INFO,
+        QStringLiteral("Setting instance not found: %1/%2").arg(path, id).toUtf8().constData()
+    );
+    if (group == m_instances.end())
+    {
+        return;
+    }
+    const auto instance = group->take(id);
+    for (const auto& record : instance.records)
+    {
+        record->clearConns();
+    }
+    if (group->isEmpty())
+    {
+        m_instances.erase(group);
+    }
+    invalidatePath(path.isEmpty() ? id : path + QLatin1Char('/') + id);
+}
+
+bool Settings::Scope::containsInstance(const QString& dir, const QString& id) const
+{
+    const auto group = m_instances.constFind(RegGroup::normalizePath(dir));
+    return group != m_instances.cend() && group->contains(id);
+}
+
+bool Settings::Scope::writeValue(const QString& key, const QVariant& value, bool emit_signal)
+{
+    Q_ASSERT(!key.isEmpty());
+    LZL_SETTINGS_TRACE_SCOPE("writeValue", key);
+
+    // 如果数据符合检查
+    auto record = historyRecord(key);
+    if (record->check(value))
+    {
+        LZL_SETTINGS_STATS_INC(record->stats.writes);
+        const auto path = RegGroup::normalizePath(key);
+        const auto changes = emit_signal ? captureChanges(path) : ValueChange();
+        beginHistory(path, record);
+        beginSharedWrite();
+        const auto written = setUserValue(path, value);
+        endSharedWrite(written ? QStringList{path} : QStringList());
+        if (!written)
+        {
+            return false;
+        }
+        // 子作用域可能依赖这个值，自己没有被覆盖时直接写入缓存
+        invalidateKey(path);
+        if (!isOverridden(path))
+        {
+            m_cache.insert(path, {record, value, Layer::User});
+        }
+        commitHistory(path, record);
+        if (emit_signal)
+        {
+            queueChanges(path, changes);
+            emitReadValuesFromKey(key);
+        }
+        return true;
+    }
+    LZL_SETTINGS_STATS_INC(record->stats.check_failures);
+    return false;
+}
+
+void Settings::Scope::setSystemIniFile(const QString& file_path)
+{
+    if (file_path.isEmpty())
+    {
+        m_system_settings.reset();
+    }
+    else
+    {
+        m_system_settings = std::make_unique<QSettings>(file_path, QSettings::IniFormat);
+    }
+    invalidatePath({});
+}
+
+bool Settings::Scope::setOverride(const QString& key, const QVariant& value, bool emit_signal)
+{
+    Q_ASSERT(!key.isEmpty());
+
+    auto record = historyRecord(key);
+    if (!record->check(value))
+    {
+        LZL_SETTINGS_STATS_INC(record->stats.check_failures);
+        return false;
+    }
+    const auto path = RegGroup::normalizePath(key);
+    const auto changes = emit_signal ? captureChanges(path) : ValueChange();
+    beginHistory(path, record);
+    m_overrides.insert(path, value);
+    // 覆盖的优先级最高，自己可以直接写入缓存
+    invalidateKey(path);
+    m_cache.insert(path, {record, value, Layer::Override});
+    commitHistory(path, record);
+    if (emit_signal)
+    {
+        queueChanges(path, changes);
+        emitReadValuesFromKey(key);
+    }
+    return true;
+}
+
+void Settings::Scope::removeOverride(const QString& key, bool emit_signal)
+{
+    Q_ASSERT(!key.isEmpty());
+
+    const auto path = RegGroup::normalizePath(key);
+    if (!m_overrides.contains(path))
+    {
+        return;
+    }
+    const auto record = historyRecord(path);
+    const auto changes = emit_signal ? captureChanges(path) : ValueChange();
+    beginHistory(path, record);
+    m_overrides.remove(path);
+    invalidateKey(path);
+    commitHistory(path, record);
+    if (emit_signal)
+    {
+        queueChanges(path, changes);
+        emitReadValuesFromKey(key);
+    }
+}
+
+void Settings::Scope::clearOverrides()
+{
+    // 注销后留下的覆盖没有记录
+    QList<QPair<QString, std::shared_ptr<const RegData>>> records;
+    for (auto it = m_overrides.cbegin(); it != m_overrides.cend(); ++it)
+    {
+        if (auto record = findData(it.key(), s_history_capacity > 0); record != nullptr)
+        {
+            beginHistory(it.key(), record);
+            records.append({it.key(), std::move(record)});
+        }
+    }
+    // 只失效被覆盖的键，其他键的缓存依然有效
+    for (auto it = m_overrides.cbegin(); it != m_overrides.cend(); ++it)
+    {
+        invalidateKey(it.key());
+    }
+    m_overrides.clear();
+    for (const auto& [key, record] : std::as_const(records))
+    {
+        commitHistory(key, record);
+    }
+}
+
+int Settings::Scope::loadOverridesFromArguments(const QStringList& arguments, const QString& option)
+{
+    const auto inline_prefix = option + QLatin1Char('=');
+    auto count = 0;
+    for (auto i = 0; i < arguments.size(); ++i)
+    {
+        QString assignment;
+        if (arguments.at(i) == option && i + 1 < arguments.size())
+        {
+            assignment = arguments.at(++i);
+        }
+        else if (arguments.at(i).startsWith(inline_prefix))
+        {
+            assignment = arguments.at(i).mid(inline_prefix.size());
+        }
+        else
+        {
+            continue;
+        }
+
+        const auto index = assignment.indexOf(QLatin1Char('='));
+        const auto key = assignment.left(index);
+        if (index <= 0 || !containsKey(key))
+        {
+            qWarning("lzl::utils::Settings: ignored override argument: %s", qUtf8Printable(assignment));
+            continue;
+        }
+        const auto value = convertLike(assignment.mid(index + 1), findRecord(key)->default_value.toVariant());
+        if (setOverride(key, value))
+        {
+            ++count;
+        }
+        else
+        {
+            qWarning("lzl::utils::Settings: override argument failed check: %s", qUtf8Printable(assignment));
+        }
+    }
+    return count;
+}
+
+int Settings::Scope::loadOverridesFromEnvironment(const QString& prefix)
+{
+    auto count = 0;
+    for (const auto& key : visibleKeys())
+    {
+        const auto name = (prefix + key.toUpper().replace(QLatin1Char('/'), QLatin1Char('_'))).toLocal8Bit();
+        if (!qEnvironmentVariableIsSet(name.constData()))
+        {
+            continue;
+        }
+        const auto like = findRecord(key)->default_value.toVariant();
+        const auto value = convertLike(qEnvironmentVariable(name.constData()), like);
+        if (setOverride(key, value))
+        {
+            ++count;
+        }
+        else
+        {
+            qWarning("lzl::utils::Settings: override environment variable failed check: %s", name.constData());
+        }
+    }
+    return count;
+}
+
+QList<Settings::HistoryEntry> Settings::Scope::history(const QString& key) const
+{
+    Q_ASSERT(!key.isEmpty());
+    return findRecord(key)->history.entries();
+}
+
+bool Settings::Scope::rollbackKey(const QString& key, qint64 timestamp, bool emit_signal)
+{
+    Q_ASSERT(!key.isEmpty());
+    return rollbackKeys({RegGroup::normalizePath(key)}, timestamp, emit_signal) > 0;
+}
+
+int Settings::Scope::rollbackGroup(const QString& dir, qint64 timestamp, bool emit_signal)
+{
+    Q_ASSERT(!dir.isEmpty());
+    return rollbackKeys(groupKeys(dir), timestamp, emit_signal);
+}
+
+QList<Settings::ValidationIssue> Settings::Scope::validateAll(int parallelism, bool emit_signal)
+{
+    LZL_SETTINGS_TRACE_SCOPE("validateAll", QString());
+
+    // 在当前线程中读取快照，设置文件只能在这个线程中访问
+    struct Candidate final
+    {
+        Scope* scope;
+        QString key;
+        std::shared_ptr<const RegData> record;
+        QVariant value;
+        Layer layer;
+    };
+    QVector<Candidate> candidates;
+    QVector<int> concurrent;
+    QVector<int> serial;
+    for (const auto& key : visibleKeys())
+    {
+        const auto record = findRecord(key);
+        for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+        {
+            if (scope->containsUserValue(key))
+            {
+                auto value = scope->userValue(key, record->default_value.toVariant());
+                (record->isCheckConcurrent() ? concurrent : serial).append(static_cast<int>(candidates.size()));
+                candidates.append({scope, key, record, std::move(value), Layer::User});
+            }
+            if (scope->m_system_settings && scope->m_system_settings->contains(key))
+            {
+                (record->isCheckConcurrent() ? concurrent : serial).append(static_cast<int>(candidates.size()));
+                candidates.append({scope, key, record, scope->m_system_settings->value(key), Layer::System});
+            }
+        }
+    }
+
+    // 每个分片只写自己的结果，不需要加锁
+    constexpr int ShardSize = 64;
+    QVector<char> valid(candidates.size(), 1);
+    const auto results = valid.data(); // 先分离，工作线程中不再调用非 const 接口
+    const auto shard_count = static_cast<int>((concurrent.size() + ShardSize - 1) / ShardSize);
+    const auto threads = parallelism > 0 ? parallelism : s_parallelism;
+    parallelFor(shard_count, threads, [&candidates, &concurrent, results](int shard) {
+        const auto end = std::min(static_cast<int>(concurrent.size()), (shard + 1) * ShardSize);
+        for (auto i = shard * ShardSize; i < end; ++i)
+        {
+            const auto& candidate = candidates.at(concurrent.at(i));
+            results[concurrent.at(i)] = candidate.record->check(candidate.value);
+        }
+    });
+    for (const auto index : std::as_const(serial))
+    {
+        valid[index] = candidates.at(index).record->check(candidates.at(index).value);
+    }
+
+    QList<ValidationIssue> issues;
+    QList<const Candidate*> repairs;
+    QStringList repaired_keys;
+    for (auto i = 0; i < candidates.size(); ++i)
+    {
+        if (valid.at(i))
+        {
+            continue;
+        }
+        const auto& candidate = candidates.at(i);
+        LZL_SETTINGS_STATS_INC(candidate.record->stats.check_failures);
+        issues.append({candidate.key, candidate.value, candidate.layer});
+        if (candidate.layer == Layer::User)
+        {
+            repairs.append(&candidate);
+            if (!repaired_keys.contains(candidate.key))
+            {
+                repaired_keys.append(candidate.key);
+            }
+        }
+    }
+    if (repairs.isEmpty())
+    {
+        return issues;
+    }
+
+    // 所有删除作为一次写入；读取旧值时也可能删除非法值，因此在这之前开始
+    QList<Scope*> scopes;
+    for (const auto candidate : std::as_const(repairs))
+    {
+        if (!scopes.contains(candidate->scope))
+        {
+            scopes.append(candidate->scope);
+            candidate->scope->beginSharedWrite();
+        }
+    }
+    QList<ValueChange> changes;
+    for (const auto& key : std::as_const(repaired_keys))
+    {
+        changes.append(emit_signal ? captureChanges(key) : ValueChange());
+        beginHistory(key, historyRecord(key));
+    }
+    for (const auto candidate : std::as_const(repairs))
+    {
+        candidate->scope->removeUserValue(candidate->key);
+        candidate->scope->invalidateKey(candidate->key);
+    }
+    for (const auto scope : std::as_const(scopes))
+    {
+        QStringList keys;
+        for (const auto candidate : std::as_const(repairs))
+        {
+            if (candidate->scope == scope)
+            {
+                keys.append(candidate->key);
+            }
+        }
+        scope->endSharedWrite(keys);
+    }
+    for (const auto& key : std::as_const(repaired_keys))
+    {
+        commitHistory(key, historyRecord(key));
+    }
+
+    if (emit_signal)
+    {
+        emitChangedKeys(repaired_keys, changes);
+    }
+    return issues;
+}
+
+int Settings::Scope::exportGroup(const QString& dir, QIODevice* device, ExportFormat format)
+{
+    Q_ASSERT(device != nullptr && device->isWritable());
+    LZL_SETTINGS_TRACE_SCOPE("exportGroup", dir);
+
+    const auto path = RegGroup::normalizePath(dir);
+    const auto prefix_size = path.isEmpty() ? 0 : path.size() + 1;
+    auto keys = groupKeys(path);
+    keys.sort();
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_12);
+    if (format == ExportFormat::Binary)
+    {
+        stream << ExportMagic << ExportVersion;
+    }
+
+    // 按分片处理：当前线程读取一个窗口的值，多个线程并行序列化其中的分片，再按顺序写入设备，
+    // 内存中只有一个窗口的数据
+    constexpr int ShardSize = 256;
+    const auto parallelism = s_parallelism > 0 ? s_parallelism : QThread::idealThreadCount();
+    const auto window_size = ShardSize * std::max(parallelism, 1);
+    auto count = 0;
+    for (auto begin = 0; begin < keys.size(); begin += window_size)
+    {
+        QVector<QPair<QString, QVariant>> entries;
+        entries.reserve(std::min(window_size, static_cast<int>(keys.size()) - begin));
+        for (auto i = begin; i < keys.size() && i < begin + window_size; ++i)
+        {
+            // 运行时覆盖的值不保存，导出覆盖之前的值
+            const auto& key = keys.at(i);
+            auto entry = getEntry(key);
+            if (entry.layer == Layer::Override)
+            {
+                entry = persistedEntry(key, entry.record);
+            }
+            entries.append({key.mid(prefix_size), entry.value.toVariant()});
+        }
+
+        const auto shard_count = static_cast<int>((entries.size() + ShardSize - 1) / ShardSize);
+        QVector<QByteArray> shards(shard_count);
+        parallelFor(shard_count, parallelism, [&entries, &shards, format](int shard) {
+            const auto end = std::min(static_cast<int>(entries.size()), (shard + 1) * ShardSize);
+            auto& bytes = shards[shard];
+            // 二进制格式没有分片级的头，各个分片的流直接拼接与逐条写入相同
+            QDataStream shard_stream(&bytes, QIODevice::WriteOnly);
+            shard_stream.setVersion(QDataStream::Qt_5_12);
+            for (auto i = shard * ShardSize; i < end; ++i)
+            {
+                const auto& entry = entries.at(i);
+                if (format == ExportFormat::Binary)
+                {
+                    shard_stream << entry.first << entry.second;
+                }
+                else
+                {
+                    QJsonObject object;
+                    object.insert(QStringLiteral("key"), entry.first);
+                    object.insert(QStringLiteral("value"), jsonFromVariant(entry.second));
+                    bytes.append(QJsonDocument(object).toJson(QJsonDocument::Compact)).append('\n');
+                }
+            }
+        });
+
+        for (const auto& bytes : std::as_const(shards))
+        {
+            if (device->write(bytes) != bytes.size())
+            {
+                return -1;
+            }
+        }
+        count += static_cast<int>(entries.size());
+    }
+    if (format == ExportFormat::Binary)
+    {
+        stream << QString();
+        if (stream.status() != QDataStream::Ok)
+        {
+            return -1;
+        }
+    }
+    return count;
+}
+
+int Settings::Scope::importGroup(const QString& dir, QIODevice* device, ExportFormat format, bool emit_signal)
+{
+    Q_ASSERT(device != nullptr && device->isReadable());
+    LZL_SETTINGS_TRACE_SCOPE("importGroup", dir);
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_12);
+    const auto start = device->pos();
+    const auto read_header = [&stream, format]() {
+        if (format != ExportFormat::Binary)
+        {
+            return true;
+        }
+        quint32 magic = 0;
+        quint32 version = 0;
+        stream >> magic >> version;
+        return magic == ExportMagic && version == ExportVersion;
+    };
+    if (!read_header())
+    {
+        qWarning("lzl::utils::Settings: import data is not a settings export.");
+        return -1;
+    }
+
+    // 读取下一个条目，转换为默认值的类型并检查；未注册或检查失败的条目跳过，只在第一遍读取时警告
+    enum class Read
+    {
+        Entry,
+        Skipped,
+        End,
+        Corrupt,
+    };
+    const auto path = RegGroup::normalizePath(dir);
+    const auto read_entry = [this, &stream, &path, device, format](QString& key, QVariant& value, bool warn) {
+        QString name;
+        if (format == ExportFormat::Binary)
+        {
+            stream >> name;
+            if (stream.status() == QDataStream::Ok && !name.isEmpty())
+            {
+                stream >> value;
+            }
+            if (stream.status() != QDataStream::Ok)
+            {
+                return Read::Corrupt;
+            }
+            if (name.isEmpty())
+            {
+                return Read::End;
+            }
+        }
+        else
+        {
+            if (device->atEnd())
+            {
+                return Read::End;
+            }
+            const auto line = device->readLine().trimmed();
+            if (line.isEmpty())
+            {
+                return Read::Skipped;
+            }
+            QJsonParseError error;
+            const auto document = QJsonDocument::fromJson(line, &error);
+            const auto object = document.object();
+            if (error.error != QJsonParseError::NoError || !document.isObject()
+                || !object.value(QStringLiteral("key")).isString())
+            {
+                return Read::Corrupt;
+            }
+            name = object.value(QStringLiteral("key")).toString();
+            value = jsonToVariant(object.value(QStringLiteral("value")));
+        }
+
+        key = RegGroup::normalizePath(path.isEmpty() ? name : path + QLatin1Char('/') + name);
+        const auto record = findData(key);
+        if (record == nullptr)
+        {
+            if (warn)
+            {
+                qWarning("lzl::utils::Settings: ignored unregistered import entry: %s", qUtf8Printable(key));
+            }
+            return Read::Skipped;
+        }
+        value = convertLike(value, record->default_value.toVariant());
+        if (!record->check(value))
+        {
+            if (warn)
+            {
+                LZL_SETTINGS_STATS_INC(record->stats.check_failures);
+                qWarning("lzl::utils::Settings: import entry failed check: %s", qUtf8Printable(key));
+            }
+            return Read::Skipped;
+        }
+        return Read::Entry;
+    };
+
+    // 可以回到开头的设备先完整读取一遍，数据损坏时不写入任何条目，之后再按窗口读取并写入，内存中只有一个窗口的值；
+    // 顺序设备（如套接字）只能读取一遍，因此先暂存所有条目再写入
+    constexpr int WindowSize = 1024;
+    const auto sequential = device->isSequential();
+    if (!sequential)
+    {
+        for (auto read = Read::Skipped; read != Read::End;)
+        {
+            QString key;
+            QVariant value;
+            read = read_entry(key, value, true);
+            if (read == Read::Corrupt)
+            {
+                qWarning("lzl::utils::Settings: import data is truncated or corrupt, nothing imported.");
+                return -1;
+            }
+        }
+        stream.resetStatus();
+        if (!device->seek(start) || !read_header())
+        {
+            qWarning("lzl::utils::Settings: import device cannot be read again, nothing imported.");
+            return -1;
+        }
+    }
+
+    // 所有条目作为一次写入，多进程共享模式下只同步一次文件，最后一起触发；同一个键出现多次时使用最后一次的值
+    QStringList written_keys;
+    QSet<QString> written;
+    QList<ValueChange> changes;
+    auto failed = false;
+    auto read = Read::Skipped;
+    beginSharedWrite();
+    while (read != Read::End && !failed)
+    {
+        QVector<QPair<QString, QVariant>> window;
+        while (read != Read::End && (sequential || window.size() < WindowSize))
+        {
+            QString key;
+            QVariant value;
+            read = read_entry(key, value, sequential);
+            if (read == Read::Corrupt)
+            {
+                // 顺序设备在写入任何条目之前就会发现；可以回到开头的设备已经检查过，只可能是读取期间被修改
+                qWarning("lzl::utils::Settings: import data is truncated or corrupt, import stopped.");
+                if (sequential)
+                {
+                    endSharedWrite({});
+                    return -1;
+                }
+                read = Read::End;
+            }
+            else if (read == Read::Entry)
+            {
+                window.append({std::move(key), std::move(value)});
+            }
+        }
+
+        for (const auto& [key, value] : std::as_const(window))
+        {
+            const auto record = historyRecord(key);
+            const auto first = !written.contains(key);
+            auto change = emit_signal && first ? captureChanges(key) : ValueChange();
+            beginHistory(key, record);
+            // 写入失败（如代理断开）时停止，只报告已经写入的条目
+            if (!setUserValue(key, value))
+            {
+                failed = true;
+                break;
+            }
+            LZL_SETTINGS_STATS_INC(record->stats.writes);
+            invalidateKey(key);
+            commitHistory(key, record);
+            if (first)
+            {
+                written.insert(key);
+                written_keys.append(key);
+                changes.append(std::move(change));
+            }
+        }
+    }
+    endSharedWrite(written_keys);
+    if (failed)
+    {
+        qWarning(
+            "lzl::utils::Settings: import stopped, settings cannot be written; %d entries imported.",
+            static_cast<int>(written_keys.size())
+        );
+    }
+
+    if (emit_signal)
+    {
+        emitChangedKeys(written_keys, changes);
+    }
+    return written_keys.size();
+}
+
+bool Settings::Scope::setProcessShared(bool shared)
+{
+    Q_ASSERT_X(
+        !m_shared || m_shared->depth == 0,
+        Q_FUNC_INFO,
+        QStringLiteral("Process sharing cannot change during a shared write: %1").arg(fileName()).toUtf8().constData()
+    );
+    if (!shared)
+    {
+        m_shared.reset();
+        return true;
+    }
+    if (m_shared)
+    {
+        return true;
+    }
+    auto state = std::make_unique<SharedState>();
+    if (!state->attach(fileName()))
+    {
+        return false;
+    }
+    m_shared = std::move(state);
+    // 开启之前缓存的可能是其他进程修改之前的值
+    settings().sync();
+    invalidatePath({});
+    return true;
+}
+
+int Settings::Scope::pollSharedChanges(bool emit_signal)
+{
+    // 只读取一个计数，没有修改时不加锁也不读取文件
+    if (!m_shared || m_shared->counter() == m_shared->seen)
+    {
+        return 0;
+    }
+    LZL_SETTINGS_TRACE_SCOPE("pollSharedChanges", fileName());
+
+    m_shared->lock();
+    QSet<quint32> hashes;
+    auto all = false;
+    m_shared->collect(hashes, all);
+    // 哈希冲突的键也会在这里，重新读取后按值是否变化过滤
+    QStringList keys;
+    for (const auto& key : visibleKeys())
+    {
+        if (all || hashes.contains(sharedKeyHash(key)))
+        {
+            keys.append(key);
+        }
+    }
+    auto reloads = beginReload(keys, emit_signal);
+    // 在锁内读取，保证读到的文件至少和计数一样新
+    settings().sync();
+    m_shared->unlock();
+    return endReload(reloads, emit_signal);
+}
+
+bool Settings::Scope::attachBroker(const QString& server_name, int timeout_ms)
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    LZL_SETTINGS_TRACE_SCOPE("attachBroker", server_name);
+    detachBroker();
+    m_broker = std::make_unique<BrokerClient>();
+    auto socket = m_broker->socket;
+
+    QElapsedTimer timer;
+    timer.start();
+    socket->connectToServer(server_name);
+    if (socket->waitForConnected(timeout_ms))
+    {
+        // 一次往返取得所有值
+        m_broker->send(brokerMessage(BrokerMessage::Read, QStringList()));
+        while (!m_broker->ready)
+        {
+            const auto remaining = timeout_ms - static_cast<int>(timer.elapsed());
+            if (remaining <= 0 || !socket->waitForReadyRead(remaining))
+            {
+                break;
+            }
+            readBroker();
+        }
+    }
+    if (!m_broker->ready)
+    {
+        qWarning(
+            "lzl::utils::Settings: cannot attach broker %s: %s",
+            qUtf8Printable(server_name),
+            qUtf8Printable(socket->errorString())
+        );
+        m_broker.reset();
+        return false;
+    }
+
+    QObject::connect(socket, &QLocalSocket::readyRead, socket, [this] { readBroker(); });
+    QObject::connect(socket, &QLocalSocket::disconnected, socket, [server_name] {
+        qWarning(
+            "lzl::utils::Settings: broker %s disconnected, values are no longer updated.", qUtf8Printable(server_name)
+        );
+    });
+    // 之前缓存的是设置文件中的值
+    invalidatePath({});
+    return true;
+#else
+    Q_UNUSED(server_name);
+    Q_UNUSED(timeout_ms);
+    qWarning("lzl::utils::Settings: broker is not compiled, enable LZL_QT_SETTINGS_ENABLE_BROKER.");
+    return false;
+#endif
+}
+
+void Settings::Scope::detachBroker()
+{
+    if (!m_broker)
+    {
+        return;
+    }
+#ifdef LZL_QT_SETTINGS_BROKER
+    // 等待还没有发送的写入
+    auto socket = m_broker->socket;
+    socket->disconnect();
+    if (socket->state() == QLocalSocket::ConnectedState)
+    {
+        socket->disconnectFromServer();
+        if (socket->state() != QLocalSocket::UnconnectedState)
+        {
+            socket->waitForDisconnected(3000);
+        }
+    }
+#endif
+    m_broker.reset();
+    invalidatePath({});
+}
+
+QFuture<QVariantHash> Settings::Scope::readValuesAsync(const QStringList& keys)
+{
+    QFutureInterface<QVariantHash> promise;
+    promise.reportStarted();
+    readAsync(keys, [promise](const QVariantHash& values) mutable {
+        promise.reportResult(values);
+        promise.reportFinished();
+    });
+    return promise.future();
+}
+
+Settings::Layer Settings::Scope::effectiveLayer(const QString& key)
+{
+    Q_ASSERT(!key.isEmpty());
+    return getEntry(key).layer;
+}
+
+bool Settings::Scope::loadStartupCache(const QString& cache_path)
+{
+    LZL_SETTINGS_TRACE_SCOPE("loadStartupCache", cache_path);
+
+    QFile file(cache_path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != StartupCacheMagic || version != StartupCacheVersion)
+    {
+        return false;
+    }
+    // 注册表或任意一层设置文件变化都会使缓存失效
+    QByteArray schema;
+    QByteArray stamps;
+    stream >> schema >> stamps;
+    if (stream.status() != QDataStream::Ok || schema != schemaHash() || stamps != fileStamps())
+    {
+        return false;
+    }
+
+    qint32 count = 0;
+    stream >> count;
+    QHash<QString, CacheEntry> entries;
+    entries.reserve(count);
+    for (auto i = 0; i < count; ++i)
+    {
+        QString key;
+        QVariant value;
+        qint8 layer = 0;
+        stream >> key >> value >> layer;
+        auto record = findData(key);
+        if (stream.status() != QDataStream::Ok || record == nullptr)
+        {
+            return false;
+        }
+        // 加载缓存之前设置的运行时覆盖依然优先
+        if (!isOverridden(key))
+        {
+            entries.insert(key, {std::move(record), value, static_cast<Layer>(layer)});
+        }
+    }
+
+    // 全部读取成功才写入缓存
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it)
+    {
+        m_cache.insert(it.key(), it.value());
+    }
+    return true;
+}
+
+bool Settings::Scope::saveStartupCache(const QString& cache_path)
+{
+    LZL_SETTINGS_TRACE_SCOPE("saveStartupCache", cache_path);
+
+    QByteArray entries;
+    QDataStream entries_stream(&entries, QIODevice::WriteOnly);
+    entries_stream.setVersion(QDataStream::Qt_5_12);
+    qint32 count = 0;
+    for (const auto& key : visibleKeys())
+    {
+        const auto& entry = getEntry(key);
+        if (entry.layer != Layer::Override)
+        {
+            entries_stream << key << entry.value.toVariant() << static_cast<qint8>(entry.layer);
+            ++count;
+        }
+    }
+    // 读取时可能删除了非法值，先写回文件再记录文件的状态
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (scope->m_q_settings)
+        {
+            scope->m_q_settings->sync();
+        }
+    }
+
+    QFile file(cache_path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << StartupCacheMagic << StartupCacheVersion << schemaHash() << fileStamps() << count;
+    stream.writeRawData(entries.constData(), static_cast<int>(entries.size()));
+    return stream.status() == QDataStream::Ok;
+}
+
+Settings::ConnId Settings::Scope::connectReadValuesFromPattern(
+    const QString& pattern, std::function<void(const QString&, const QVariant&)> read_func
+)
+{
+    Q_ASSERT(!pattern.isEmpty());
+
+    // 插入前缀树
+    const auto words = RegGroup::detachPath(pattern);
+    auto id = generateId();
+    auto node = &s_patterns;
+    for (const auto& word : words)
+    {
+        auto& child = node->children[internSegment(word)];
+        if (!child)
+        {
+            child = std::make_shared<PatternNode>();
+        }
+        node = child.get();
+    }
+    node->conn_ids.append(id);
+
+    auto& conn = s_conns[id];
+    conn.read = std::make_shared<const std::function<void(void)>>(
+        [this, id, words, read_func = std::move(read_func)]() {
+            // 没有指定键时（如直接触发这个 id）对所有匹配的键各调用一次
+            auto keys = s_emit_keys.take(id);
+            if (keys.isEmpty())
+            {
+                for (const auto& key : visibleKeys())
+                {
+                    if (matchPattern(words, RegGroup::detachPath(key)))
+                    {
+                        keys.append(key);
+                    }
+                }
+            }
+            for (const auto& key : std::as_const(keys))
+            {
+                // 键可能在之前的回调中被注销
+                if (containsKey(key))
+                {
+                    read_func(key, getValue(key));
+                }
+            }
+        }
+    );
+    conn.disconnect = [words, id]() {
+        removePatternConn(words, id);
+        s_emit_keys.remove(id);
+    };
+    conn.scope = this;
+#ifdef LZL_QT_SETTINGS_TRACE
+    conn.key = pattern;
+#endif
+    return id;
+}
+
+Settings::ConnId Settings::Scope::insertChangeConn(
+    const QString& key, std::function<void(const QVariant&, const QVariant&)>&& changed_func
+)
+{
+    const auto path = RegGroup::normalizePath(key);
+    const auto id = insertConn(this, key, findRecord(key, true), {});
+    auto& conn = s_conns[id];
+    conn.with_change = true;
+    conn.read = std::make_shared<const std::function<void(void)>>(
+        [this, id, path, changed_func = std::move(changed_func)]() {
+            if (auto it = s_emit_changes.find(path); it != s_emit_changes.end() && it->conn_ids.remove(id))
+            {
+                const auto old_value = it->old_values.value(this);
+                if (it->conn_ids.isEmpty())
+                {
+                    s_emit_changes.erase(it);
+                }
+                changed_func(old_value, getValue(path));
+            }
+            else
+            {
+                // 没有写入（如直接触发）时旧值和新值相同
+                const auto value = getValue(path);
+                changed_func(value, value);
+            }
+        }
+    );
+    conn.disconnect = [disconnect = std::move(conn.disconnect), id, path]() {
+        disconnect();
+        const auto it = s_emit_changes.find(path);
+        if (it != s_emit_changes.end() && it->conn_ids.remove(id) && it->conn_ids.isEmpty())
+        {
+            s_emit_changes.erase(it);
+        }
+    };
+    return id;
+}
+
+void Settings::Scope::disconnectReadValuesFromKey(const QString& key)
+{
+    for (const auto id : getConnIdsFromKey(key))
+    {
+        disconnectReadValue(id);
+    }
+}
+
+void Settings::Scope::disconnectReadValuesFromGroup(const QString& dir)
+{
+    for (const auto id : getConnIdsFromGroup(dir))
+    {
+        disconnectReadValue(id);
+    }
+}
+
+void Settings::Scope::disconnectAllReadValues()
+{
+    for (const auto id : getConnIds())
+    {
+        disconnectReadValue(id);
+    }
+}
+
+void Settings::Scope::emitReadValuesFromKey(const QString& key)
+{
+    auto conn_ids = getConnIdsFromKey(key);
+    conn_ids.append(queuePatternKeys({RegGroup::normalizePath(key)}));
+    emitReadValues(conn_ids);
+}
+
+void Settings::Scope::emitReadValuesFromGroup(const QString& dir)
+{
+    auto conn_ids = getConnIdsFromGroup(dir);
+    conn_ids.append(queuePatternKeys(groupKeys(dir)));
+    emitReadValues(conn_ids);
+}
+
+void Settings::Scope::emitReadValuesFromGroupDeferred(const QString& dir, int priority)
+{
+    // 模式订阅的键在执行时才交给调度，否则会被之前的同步触发取走
+    QHash<ConnId, QStringList> pattern_keys;
+    for (const auto& key : groupKeys(dir))
+    {
+        for (const auto id : filterConns(matchPatterns(key)))
+        {
+            pattern_keys[id].append(key);
+        }
+    }
+    deferEmits(getConnIdsFromGroup(dir), pattern_keys, priority);
+}
+
+void Settings::Scope::emitAllReadValues()
+{
+    emitReadValues(getConnIds());
+}
+
+QList<Settings::ConnId> Settings::Scope::getConnIds() const
+{
+    QList<ConnId> conn_ids;
+    for (auto it = s_conns.cbegin(); it != s_conns.cend(); ++it)
+    {
+        if (covers(it->scope))
+        {
+            conn_ids.append(it.key());
+        }
+    }
+    return conn_ids;
+}
+
+void Settings::Scope::checkIntegrity(QStringList& problems) const
+{
+    const auto id_text = [](ConnId id) { return QString::number(static_cast<std::size_t>(id)); };
+    const auto join = [](const QString& dir, const QString& name) {
+        return dir.isEmpty() ? name : dir + QLatin1Char('/') + name;
+    };
+
+    // 读取事件 -> 所属的键或模式
+    QHash<ConnId, QString> owners;
+    const auto own = [&problems, &owners, &id_text](ConnId id, const QString& owner) {
+        if (!s_conns.contains(id))
+        {
+            problems.append(QStringLiteral("connection %1 of `%2` not found").arg(id_text(id), owner));
+        }
+        else if (auto it = owners.constFind(id); it != owners.cend())
+        {
+            problems.append(QStringLiteral("connection %1 owned by `%2` and `%3`").arg(id_text(id), *it, owner));
+        }
+        else
+        {
+            owners.insert(id, owner);
+        }
+    };
+
+    std::function<void(const RegGroup*, const QString&)> check_group;
+    check_group = [&](const RegGroup* group, const QString& dir) {
+        for (auto i = 0; i < group->dataset.size(); ++i)
+        {
+            const auto key = join(dir, segmentName(group->dataset.keyAt(i)));
+            for (const auto id : group->dataset.valueAt(i)->conn_ids)
+            {
+                own(id, key);
+            }
+        }
+        for (auto i = 0; i < group->groupset.size(); ++i)
+        {
+            const auto sub_dir = join(dir, segmentName(group->groupset.keyAt(i)));
+            if (group->groupset.valueAt(i)->isEmpty())
+            {
+                problems.append(QStringLiteral("empty registry group `%1`").arg(sub_dir));
+            }
+            check_group(group->groupset.valueAt(i).get(), sub_dir);
+        }
+    };
+    std::function<void(const Scope*)> check_scope;
+    check_scope = [&](const Scope* scope) {
+        const auto regedit = scope->registry();
+        check_group(regedit.get(), {});
+        for (auto group = scope->m_instances.cbegin(); group != scope->m_instances.cend(); ++group)
+        {
+            for (auto instance = group->cbegin(); instance != group->cend(); ++instance)
+            {
+                const auto prefix = join(group.key(), instance.key());
+                for (auto record = instance->records.cbegin(); record != instance->records.cend(); ++record)
+                {
+                    for (const auto id : (*record)->conn_ids)
+                    {
+                        own(id, join(prefix, record.key()));
+                    }
+                }
+            }
+        }
+        for (const auto child : scope->m_children)
+        {
+            check_scope(child);
+        }
+    };
+    check_scope(this);
+
+    std::function<void(const PatternNode*, const QString&)> check_pattern;
+    check_pattern = [&](const PatternNode* node, const QString& pattern) {
+        for (const auto id : node->conn_ids)
+        {
+            own(id, pattern);
+        }
+        for (auto it = node->children.cbegin(); it != node->children.cend(); ++it)
+        {
+            const auto sub_pattern = join(pattern, segmentName(it.key()));
+            if (it.value()->conn_ids.isEmpty() && it.value()->children.isEmpty())
+            {
+                problems.append(QStringLiteral("empty pattern node `%1`").arg(sub_pattern));
+            }
+            check_pattern(it.value().get(), sub_pattern);
+        }
+    };
+    check_pattern(&s_patterns, {});
+
+    // 通过当前作用域及其子作用域绑定的读取事件都应该有所属
+    for (auto it = s_conns.cbegin(); it != s_conns.cend(); ++it)
+    {
+        if (covers(it->scope) && !owners.contains(it.key()))
+        {
+            problems.append(QStringLiteral("connection %1 has no owner").arg(id_text(it.key())));
+        }
+    }
+
+    // 等待触发的事件不重复，不执行时队列为空
+    if (s_emit_pending.size() != s_emit_queue.size())
+    {
+        problems.append(QStringLiteral("emit queue has %1 entries but %2 pending ids")
+                            .arg(s_emit_queue.size())
+                            .arg(s_emit_pending.size()));
+    }
+    if (!s_emit_draining && !s_emit_queue.isEmpty())
+    {
+        problems.append(QStringLiteral("emit queue not drained: %1 entries").arg(s_emit_queue.size()));
+    }
+    if (s_deferred_queue.size() != s_deferred_keys.size())
+    {
+        problems.append(QStringLiteral("deferred queue has %1 entries but %2 pending ids")
+                            .arg(s_deferred_queue.size())
+                            .arg(s_deferred_keys.size()));
+    }
+}
+
+QList<Settings::ConnId> Settings::Scope::getConnIdsFromKey(const QString& key)
+{
+    Q_ASSERT(!key.isEmpty());
+    // 在 findRecord 中 Q_ASSERT_X 会确保 record 不为空
+    return filterConns(findRecord(key)->conn_ids);
+}
+
+QList<Settings::ConnId> Settings::Scope::getConnIdsFromGroup(const QString& dir)
+{
+    Q_ASSERT(!dir.isEmpty());
+    QList<ConnId> conn_ids;
+    // 组可能分布在多个作用域的注册表中
+    auto found = false;
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        // 持有快照，保证遍历期间组不会被释放
+        const auto regedit = scope->registry();
+        if (auto group = regedit->findGroup(dir); group != nullptr)
+        {
+            found = true;
+            Settings::getConnIdsFromGroup(group, conn_ids);
+        }
+        // 实例的键只有创建了记录的才可能绑定过读取事件
+        const auto path = RegGroup::normalizePath(dir);
+        for (auto group = scope->m_instances.cbegin(); group != scope->m_instances.cend(); ++group)
+        {
+            for (auto instance = group->cbegin(); instance != group->cend(); ++instance)
+            {
+                const auto prefix =
+                    group.key().isEmpty() ? instance.key() : group.key() + QLatin1Char('/') + instance.key();
+                found = found || isUnderPath(prefix, path) || isUnderPath(path, prefix);
+                const auto& records = instance->records;
+                for (auto record = records.cbegin(); record != records.cend(); ++record)
+                {
+                    if (isUnderPath(prefix + QLatin1Char('/') + record.key(), path))
+                    {
+                        conn_ids.append((*record)->conn_ids);
+                    }
+                }
+            }
+        }
+    }
+    Q_ASSERT_X(
+        found,
+        Q_FUNC_INFO,
+        QStringLiteral("Setting registration `group` not found: %1").arg(dir).toUtf8().constData()
+    );
+    Q_UNUSED(found);
+    conn_ids = filterConns(conn_ids);
+    std::sort(conn_ids.begin(), conn_ids.end());
+    return conn_ids;
+}
+
+// 作用域的辅助函数
+/* ========================================================================== */
+
+QSettings& Settings::Scope::settings()
+{
+    if (!m_q_settings)
+    {
+        m_q_settings = std::make_unique<QSettings>(m_file_name, QSettings::IniFormat);
+        // 之后的读写都通过 QSettings，只读阶段的解析结果不会随写入更新
+        m_ini.reset();
+    }
+    return *m_q_settings;
+}
+
+bool Settings::Scope::usesIniParser() const
+{
+    return m_ini != nullptr;
+}
+
+Settings::Scope::IniFile* Settings::Scope::iniFile()
+{
+    if (!m_ini && !m_q_settings)
+    {
+        // 追踪的状态只能在当前线程中访问，因此只在同步解析时记录，工作线程中的解析不记录
+        LZL_SETTINGS_TRACE_SCOPE("parseIni", m_file_name);
+        m_ini = IniFile::parse(m_file_name);
+        if (!m_ini)
+        {
+            Q_UNUSED(settings());
+        }
+    }
+    return m_ini.get();
+}
+
+bool Settings::Scope::containsUserValue(const QString& key)
+{
+    if (m_broker)
+    {
+        return m_broker->values.contains(key);
+    }
+    if (auto ini = iniFile())
+    {
+        return ini->values.contains(key);
+    }
+    return settings().contains(key);
+}
+
+QVariant Settings::Scope::userValue(const QString& key, const QVariant& like)
+{
+    // 代理中的值来自 QSettings::value()，INI 文件中的值同样是文本
+    if (m_broker)
+    {
+        return convertLike(m_broker->values.value(key), like);
+    }
+    // 文件中的值都是文本，每个键只在第一次读取时转换，之后命中缓存
+    if (auto ini = iniFile())
+    {
+        return convertLike(ini->values.value(key), like);
+    }
+    return convertLike(settings().value(key), like);
+}
+
+bool Settings::Scope::setUserValue(const QString& key, const QVariant& value)
+{
+    if (!m_broker)
+    {
+        settings().setValue(key, value);
+        return true;
+    }
+    // 代理断开时不修改本地的副本，否则和代理中的值不一致
+    if (!m_broker->send(brokerMessage(BrokerMessage::Write, QVariantHash{{key, value}})))
+    {
+        return false;
+    }
+    m_broker->values.insert(key, value);
+    return true;
+}
+
+bool Settings::Scope::removeUserValue(const QString& path)
+{
+    if (!m_broker)
+    {
+        settings().remove(path);
+        return true;
+    }
+    if (!m_broker->send(brokerMessage(BrokerMessage::Remove, QStringList{path})))
+    {
+        return false;
+    }
+    for (auto it = m_broker->values.begin(); it != m_broker->values.end();)
+    {
+        it = isUnderPath(it.key(), path) ? m_broker->values.erase(it) : std::next(it);
+    }
+    return true;
+}
+
+void Settings::Scope::clearUserValues()
+{
+    if (!m_broker)
+    {
+        settings().clear();
+        return;
+    }
+    // 空路径表示所有键
+    removeUserValue({});
+}
+
+void Settings::Scope::readBroker()
+{
+#ifdef LZL_QT_SETTINGS_BROKER
+    // 先读出所有完整的消息，应用时的回调可能断开代理
+    struct Message final
+    {
+        quint8 type;
+        QVariantHash values;
+        QStringList removed;
+    };
+    QList<Message> messages;
+    QDataStream stream(m_broker->socket);
+    stream.setVersion(QDataStream::Qt_5_12);
+    while (true)
+    {
+        stream.startTransaction();
+        Message message = {0, {}, {}};
+        stream >> message.type;
+        if (message.type == static_cast<quint8>(BrokerMessage::Values))
+        {
+            stream >> message.values;
+        }
+        else if (message.type == static_cast<quint8>(BrokerMessage::Changed))
+        {
+            stream >> message.values >> message.removed;
+        }
+        else if (stream.status() == QDataStream::Ok)
+        {
+            qWarning("lzl::utils::Settings: received an unknown message from broker, disconnected.");
+            stream.abortTransaction();
+            m_broker->socket->abort();
+            break;
+        }
+        if (!stream.commitTransaction())
+        {
+            break;
+        }
+        messages.append(std::move(message));
+    }
+
+    for (const auto& message : std::as_const(messages))
+    {
+        if (!m_broker)
+        {
+            return;
+        }
+        if (message.type == static_cast<quint8>(BrokerMessage::Values))
+        {
+            m_broker->values = message.values;
+            m_broker->ready = true;
+            continue;
+        }
+        // 连接完成之前的推送会被所有值覆盖，不需要触发
+        QStringList keys;
+        if (m_broker->ready)
+        {
+            for (const auto& key : visibleKeys())
+            {
+                const auto under = [&key](const auto& path) { return isUnderPath(key, path); };
+                const auto removed = std::any_of(message.removed.cbegin(), message.removed.cend(), under);
+                if (removed || message.values.contains(key))
+                {
+                    keys.append(key);
+                }
+            }
+        }
+        auto reloads = beginReload(keys, true);
+        for (const auto& path : message.removed)
+        {
+            for (auto it = m_broker->values.begin(); it != m_broker->values.end();)
+            {
+                it = isUnderPath(it.key(), path) ? m_broker->values.erase(it) : std::next(it);
+            }
+        }
+        for (auto it = message.values.cbegin(); it != message.values.cend(); ++it)
+        {
+            m_broker->values.insert(it.key(), it.value());
+        }
+        endReload(reloads, true);
+    }
+#endif
+}
+
+bool Settings::Scope::isLoaded() const
+{
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (!scope->m_broker && !scope->m_q_settings && !scope->m_ini)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Settings::Scope::readAsync(const QStringList& keys, std::function<void(const QVariantHash&)>&& resolve)
+{
+    // 所有键都已经缓存，或者不需要解析文件时立即完成
+    const auto cached = std::all_of(keys.cbegin(), keys.cend(), [this](const QString& key) {
+        return m_cache.contains(RegGroup::normalizePath(key));
+    });
+    if (cached || isLoaded())
+    {
+        QVariantHash values;
+        for (const auto& key : keys)
+        {
+            values.insert(key, getValue(key));
+        }
+        resolve(values);
+        return;
+    }
+
+    // 加载期间的读取都等待同一次加载
+    if (!m_async)
+    {
+        m_async = std::make_unique<AsyncLoad>();
+    }
+    m_async->reads.append({keys, std::move(resolve)});
+    if (m_async->thread == nullptr)
+    {
+        startAsyncLoad();
+    }
+}
+
+void Settings::Scope::startAsyncLoad()
+{
+    LZL_SETTINGS_TRACE_SCOPE("startAsyncLoad", fileName());
+
+    QList<Scope*> scopes;
+    QStringList file_names;
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (!scope->m_broker && !scope->m_q_settings && !scope->m_ini)
+        {
+            scopes.append(scope);
+            file_names.append(scope->m_file_name);
+        }
+    }
+
+    // 在工作线程中解析文件；不能解析时改用 QSettings，它在第一次访问时才解析，访问一次后再移回作用域的线程
+    auto loaded = std::make_shared<std::vector<LoadedFile>>();
+    const auto target = QThread::currentThread();
+    m_async->thread = QThread::create([file_names, loaded, target] {
+        for (const auto& file_name : file_names)
+        {
+            auto ini = IniFile::parse(file_name);
+            std::unique_ptr<QSettings> settings;
+            if (!ini)
+            {
+                settings = std::make_unique<QSettings>(file_name, QSettings::IniFormat);
+                Q_UNUSED(settings->allKeys());
+                settings->moveToThread(target);
+            }
+            loaded->emplace_back(std::move(ini), std::move(settings));
+        }
+    });
+    m_async->thread->setParent(&m_async->context);
+    QObject::connect(m_async->thread, &QThread::finished, &m_async->context, [this, scopes, loaded] {
+        finishAsyncLoad(scopes, *loaded);
+    });
+    m_async->thread->start();
+}
+
+void Settings::Scope::finishAsyncLoad(const QList<Scope*>& scopes, std::vector<LoadedFile>& loaded)
+{
+    LZL_SETTINGS_TRACE_SCOPE("finishAsyncLoad", fileName());
+
+    m_async->thread->deleteLater();
+    m_async->thread = nullptr;
+    // 父作用域一定比自己存活更久；等待期间可能已经同步打开了文件或连接了代理
+    for (std::size_t i = 0; i < loaded.size(); ++i)
+    {
+        if (auto scope = scopes.at(static_cast<int>(i)); !scope->m_broker && !scope->m_q_settings && !scope->m_ini)
+        {
+            scope->m_ini = std::move(loaded[i].first);
+            scope->m_q_settings = std::move(loaded[i].second);
+        }
+    }
+
+    // 先读出所有值再完成，完成时的回调可能析构作用域
+    QList<QPair<std::function<void(const QVariantHash&)>, QVariantHash>> results;
+    for (auto& [keys, resolve] : std::exchange(m_async->reads, {}))
+    {
+        QVariantHash values;
+        for (const auto& key : std::as_const(keys))
+        {
+            // 等待期间可能被注销
+            if (containsKey(key))
+            {
+                values.insert(key, getValue(key));
+            }
+        }
+        results.append({std::move(resolve), std::move(values)});
+    }
+    for (const auto& [resolve, values] : std::as_const(results))
+    {
+        resolve(values);
+    }
+}
+
+void Settings::Scope::publishRegistry(RegGroup&& regedit)
+{
+    std::shared_ptr<const RegGroup> published = makeNode<RegGroup>(std::move(regedit));
+#if defined(__cpp_lib_atomic_shared_ptr)
+    m_regedit.store(std::move(published), std::memory_order_release);
+#else
+    std::atomic_store_explicit(&m_regedit, std::move(published), std::memory_order_release);
+#endif
+}
+
+std::shared_ptr<const Settings::RegData> Settings::Scope::findData(const QString& key, bool create) const
+{
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (auto data = scope->registry()->findData(key); data != nullptr)
+        {
+            return data;
+        }
+        if (auto data = scope->findInstanceData(key, create); data != nullptr)
+        {
+            return data;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const Settings::RegData> Settings::Scope::historyRecord(const QString& key) const
+{
+    return findRecord(key, s_history_capacity > 0);
+}
+
+std::shared_ptr<const Settings::RegData> Settings::Scope::findRecord(const QString& key, bool create) const
+{
+    auto data = findData(key, create);
+    Q_ASSERT_X(
+        data != nullptr,
+        Q_FUNC_INFO,
+        QStringLiteral("Setting registration `record` not found: %1").arg(key).toUtf8().constData()
+    );
+    return data;
+}
+
+std::shared_ptr<const Settings::RegData> Settings::Scope::findInstanceData(const QString& key, bool create) const
+{
+    if (m_instances.isEmpty())
+    {
+        return nullptr;
+    }
+    // 把路径的每个前缀当作模板组的路径直接查找，之后的一段是实例 id，其余是模板中的路径；
+    // 查找的次数只取决于路径的深度，与模板组的数量无关
+    const auto path = RegGroup::normalizePath(key);
+    for (decltype(path.size()) begin = 0;;)
+    {
+        const auto end = path.indexOf(QLatin1Char('/'), begin);
+        if (end < 0)
+        {
+            return nullptr;
+        }
+        const auto dir = begin == 0 ? QString() : path.left(begin - 1);
+        const auto id = path.mid(begin, end - begin);
+        begin = end + 1;
+        const auto group = m_instances.find(dir);
+        if (group == m_instances.end())
+        {
+            continue;
+        }
+        const auto instance = group->find(id);
+        if (instance == group->end())
+        {
+            continue;
+        }
+        const auto name = path.mid(end + 1);
+        if (auto record = instance->records.constFind(name); record != instance->records.cend())
+        {
+            return *record;
+        }
+        // 指向模板的记录，只有覆盖了默认值的键才不使用模板的默认值
+        const auto prefix = dir.isEmpty() ? QStringLiteral("*/") : dir + QStringLiteral("/*/");
+        auto templ = findData(prefix + name);
+        if (templ == nullptr)
+        {
+            continue;
+        }
+        if (!create)
+        {
+            // 临时的记录在模板的记录没有改变时复用，不会每次查找都分配
+            if (auto cached = instance->transients.constFind(name);
+                cached != instance->transients.cend() && (*cached)->schema == templ)
+            {
+                return *cached;
+            }
+        }
+        const auto it = instance->defaults.constFind(name);
+        auto default_value = it != instance->defaults.cend() ? CompactValue(*it) : templ->default_value;
+        if (create)
+        {
+            instance->transients.remove(name);
+            auto record = makeRecord(std::move(default_value), {}, true, std::move(templ));
+            return *instance->records.insert(name, std::move(record));
+        }
+        // 批量操作只需要默认值和检查，临时的记录不绑定事件，也不分配历史
+        auto data = RegData{std::move(default_value), {}};
+        data.schema = std::move(templ);
+        data.concurrent_check = true;
+        return *instance->transients.insert(name, makeNode<RegData>(std::move(data)));
+    }
+}
+
+QStringList Settings::Scope::instanceKeys(const QString& dir) const
+{
+    QStringList keys;
+    for (auto group = m_instances.cbegin(); group != m_instances.cend(); ++group)
+    {
+        const auto templ_dir = group.key().isEmpty() ? QStringLiteral("*") : group.key() + QStringLiteral("/*");
+        QStringList names;
+        for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+        {
+            const auto regedit = scope->registry();
+            if (auto templ = regedit->findGroup(templ_dir); templ != nullptr)
+            {
+                names.append(templ->keys());
+            }
+        }
+        names.removeDuplicates();
+        for (auto it = group->cbegin(); it != group->cend(); ++it)
+        {
+            const auto prefix = group.key().isEmpty() ? it.key() : group.key() + QLatin1Char('/') + it.key();
+            for (const auto& name : std::as_const(names))
+            {
+                if (auto key = prefix + QLatin1Char('/') + name; dir.isEmpty() || isUnderPath(key, dir))
+                {
+                    keys.append(key);
+                }
+            }
+        }
+    }
+    return keys;
+}
+
+void Settings::Scope::dropInstances(const QString& path)
+{
+    for (auto group = m_instances.begin(); group != m_instances.end();)
+    {
+        const auto templ_dir = group.key().isEmpty() ? QStringLiteral("*") : group.key() + QStringLiteral("/*");
+        // 模板组已经不存在时删除所有实例，否则只删除模板被注销的键
+        const auto drop_all = !containsGroup(templ_dir);
+        for (auto& instance : *group)
+        {
+            instance.transients.clear();
+            auto& records = instance.records;
+            for (auto it = records.begin(); it != records.end();)
+            {
+                if (drop_all || path.isEmpty() || isUnderPath(templ_dir + QLatin1Char('/') + it.key(), path))
+                {
+                    (*it)->clearConns();
+                    it = records.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+        group = drop_all ? m_instances.erase(group) : std::next(group);
+    }
+}
+
+const Settings::Scope::CacheEntry& Settings::Scope::getEntry(const QString& key)
+{
+    const auto path = RegGroup::normalizePath(key);
+    if (auto it = m_cache.constFind(path); it != m_cache.cend())
+    {
+        LZL_SETTINGS_STATS_INC(it->record->stats.reads);
+        LZL_SETTINGS_STATS_INC(it->record->stats.cache_hits);
+        return *it;
+    }
+
+    auto record = findRecord(path);
+    LZL_SETTINGS_STATS_INC(record->stats.reads);
+    return *m_cache.insert(path, resolveEntry(path, record));
+}
+
+const Settings::Scope::CacheEntry& Settings::Scope::peekEntry(
+    const QString& key, const std::shared_ptr<const RegData>& record
+)
+{
+    if (auto it = m_cache.constFind(key); it != m_cache.cend())
+    {
+        return *it;
+    }
+    return *m_cache.insert(key, resolveEntry(key, record));
+}
+
+Settings::Scope::CacheEntry Settings::Scope::resolveEntry(
+    const QString& key, const std::shared_ptr<const RegData>& record
+)
+{
+    // 每一层都沿着作用域链查找，覆盖的值在设置时已经检查过
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (auto it = scope->m_overrides.constFind(key); it != scope->m_overrides.cend())
+        {
+            return {record, *it, Layer::Override};
+        }
+    }
+    return persistedEntry(key, record);
+}
+
+Settings::Scope::CacheEntry Settings::Scope::persistedEntry(
+    const QString& key, const std::shared_ptr<const RegData>& record
+)
+{
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (!scope->containsUserValue(key))
+        {
+            continue;
+        }
+        if (auto value = scope->userValue(key, record->default_value.toVariant()); record->check(value))
+        {
+            return {record, value, Layer::User};
+        }
+        LZL_SETTINGS_STATS_INC(record->stats.check_failures);
+        // 删除非法值以使用下一个作用域或下一层的值，多进程共享模式下同样需要加锁并发布
+        scope->beginSharedWrite();
+        scope->removeUserValue(key);
+        scope->endSharedWrite({key});
+    }
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        if (!scope->m_system_settings || !scope->m_system_settings->contains(key))
+        {
+            continue;
+        }
+        // 系统设置文件是只读的，非法值只忽略
+        if (auto value = scope->m_system_settings->value(key); record->check(value))
+        {
+            return {record, value, Layer::System};
+        }
+        LZL_SETTINGS_STATS_INC(record->stats.check_failures);
+    }
+    return {record, record->default_value, Layer::Default};
+}
+
+QStringList Settings::Scope::visibleKeys()
+{
+    QStringList keys;
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        keys.append(scope->registry()->keys());
+        keys.append(scope->instanceKeys({}));
+    }
+    keys.removeDuplicates();
+    return keys;
+}
+
+QStringList Settings::Scope::groupKeys(const QString& dir)
+{
+    const auto path = RegGroup::normalizePath(dir);
+    QStringList keys;
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+    {
+        const auto regedit = scope->registry();
+        if (auto group = regedit->findGroup(path); group != nullptr)
+        {
+            keys.append(group->keys(path));
+        }
+        keys.append(scope->instanceKeys(path));
+    }
+    keys.removeDuplicates();
+    return keys;
+}
+
+QList<Settings::ConnId> Settings::Scope::queuePatternKeys(const QStringList& keys) const
+{
+    QList<ConnId> conn_ids;
+    for (const auto& key : keys)
+    {
+        for (const auto id : filterConns(matchPatterns(key)))
+        {
+            auto& pending = s_emit_keys[id];
+            if (pending.isEmpty())
+            {
+                conn_ids.append(id);
+            }
+            if (!pending.contains(key))
+            {
+                pending.append(key);
+            }
+        }
+    }
+    return conn_ids;
+}
+
+Settings::ValueChange Settings::Scope::captureChanges(const QString& key)
+{
+    // 旧值通常已经在各自作用域的缓存中，不需要读取设置文件
+    ValueChange change;
+    for (const auto id : filterConns(findRecord(key)->conn_ids))
+    {
+        if (const auto& conn = s_conns[id]; conn.with_change)
+        {
+            if (!change.old_values.contains(conn.scope))
+            {
+                change.old_values.insert(conn.scope, conn.scope->getValue(key));
+            }
+            change.conn_ids.insert(id);
+        }
+    }
+    return change;
+}
+
+void Settings::Scope::queueChanges(const QString& key, const ValueChange& change)
+{
+    if (change.conn_ids.isEmpty())
+    {
+        return;
+    }
+    // 还没有触发的变化保留最早的旧值
+    auto& pending = s_emit_changes[key];
+    for (auto it = change.old_values.cbegin(); it != change.old_values.cend(); ++it)
+    {
+        if (!pending.old_values.contains(it.key()))
+        {
+            pending.old_values.insert(it.key(), it.value());
+        }
+    }
+    pending.conn_ids.unite(change.conn_ids);
+}
+
+void Settings::Scope::beginHistory(const QString& key, const std::shared_ptr<const RegData>& record)
+{
+    // 修改前的值通常已经在缓存中
+    if (record->history.isEnabled() && record->history.isEmpty())
+    {
+        const auto& entry = peekEntry(key, record);
+        record->history.append({record->history.created(), entry.value.toVariant(), entry.layer});
+    }
+}
+
+void Settings::Scope::commitHistory(const QString& key, const std::shared_ptr<const RegData>& record)
+{
+    if (!record->history.isEnabled())
+    {
+        return;
+    }
+    const auto& entry = peekEntry(key, record);
+    if (const auto& last = record->history.last(); last.value != entry.value.toVariant() || last.source != entry.layer)
+    {
+        record->history.append({QDateTime::currentMSecsSinceEpoch(), entry.value.toVariant(), entry.layer});
+    }
+}
+
+int Settings::Scope::rollbackKeys(const QStringList& keys, qint64 timestamp, bool emit_signal)
+{
+    QStringList rolled_keys;
+    QStringList file_keys;
+    QList<ValueChange> changes;
+    beginSharedWrite();
+    for (const auto& key : keys)
+    {
+        const auto record = findRecord(key);
+        const auto target = record->history.find(timestamp);
+        if (target == nullptr)
+        {
+            continue;
+        }
+        // 先复制，追加记录时可能覆盖它
+        const auto value = target->value;
+        const auto source = target->source;
+        if (const auto& entry = peekEntry(key, record); entry.value.toVariant() == value && entry.layer == source)
+        {
+            continue;
+        }
+
+        auto change = emit_signal ? captureChanges(key) : ValueChange();
+        // 写回原来的层，低于设置文件的层通过移除设置文件中的值恢复
+        if (source == Layer::Override)
+        {
+            m_overrides.insert(key, value);
+        }
+        else
+        {
+            // 写入失败（如代理断开）时跳过这个键，不记录历史也不触发
+            if (!(source == Layer::User ? setUserValue(key, value) : removeUserValue(key)))
+            {
+                continue;
+            }
+            m_overrides.remove(key);
+            file_keys.append(key);
+        }
+        invalidateKey(key);
+        commitHistory(key, record);
+        rolled_keys.append(key);
+        changes.append(std::move(change));
+    }
+    endSharedWrite(file_keys);
+
+    if (emit_signal)
+    {
+        emitChangedKeys(rolled_keys, changes);
+    }
+    return rolled_keys.size();
+}
+
+void Settings::Scope::emitChangedKeys(
+    const QStringList& keys, const QList<ValueChange>& changes
+)
+{
+    Q_ASSERT(keys.size() == changes.size());
+    QList<ConnId> conn_ids;
+    for (auto i = 0; i < keys.size(); ++i)
+    {
+        queueChanges(keys.at(i), changes.at(i));
+        conn_ids.append(getConnIdsFromKey(keys.at(i)));
+    }
+    conn_ids.append(queuePatternKeys(keys));
+    emitReadValues(conn_ids);
+}
+
+QList<Settings::Scope::ReloadEntry> Settings::Scope::beginReload(const QStringList& keys, bool emit_signal)
+{
+    QList<ReloadEntry> reloads;
+    for (const auto& key : keys)
+    {
+        auto record = historyRecord(key);
+        beginHistory(key, record);
+        auto old_value = peekEntry(key, record).value.toVariant();
+        auto changes = emit_signal ? captureChanges(key) : ValueChange();
+        reloads.append({key, std::move(record), std::move(old_value), std::move(changes)});
+    }
+    return reloads;
+}
+
+int Settings::Scope::endReload(QList<ReloadEntry>& reloads, bool emit_signal)
+{
+    for (const auto& reload : std::as_const(reloads))
+    {
+        invalidateKey(reload.key);
+    }
+    resolveEntries(reloads);
+    QStringList changed_keys;
+    QList<ValueChange> changes;
+    for (auto& reload : reloads)
+    {
+        if (peekEntry(reload.key, reload.record).value.toVariant() == reload.old_value)
+        {
+            continue;
+        }
+        commitHistory(reload.key, reload.record);
+        changed_keys.append(reload.key);
+        changes.append(std::move(reload.changes));
+    }
+    if (emit_signal)
+    {
+        emitChangedKeys(changed_keys, changes);
+    }
+    return changed_keys.size();
+}
+
+void Settings::Scope::resolveEntries(const QList<ReloadEntry>& reloads)
+{
+    // 与 resolveEntry 相同的顺序，但检查在多个线程中并行；值在当前线程中读取，设置文件只能在这个线程中访问
+    struct Candidate final
+    {
+        int reload;
+        Scope* scope;
+        QVariant value;
+        Layer layer;
+    };
+    QVector<Candidate> candidates;
+    QVector<int> begins; // 第 i 个键的候选值是 [begins[i], begins[i + 1])
+    QVector<int> concurrent;
+    QVector<int> serial;
+    begins.reserve(reloads.size() + 1);
+    for (auto i = 0; i < reloads.size(); ++i)
+    {
+        begins.append(static_cast<int>(candidates.size()));
+        const auto& key = reloads.at(i).key;
+        const auto& record = reloads.at(i).record;
+        // 覆盖的值在设置时已经检查过
+        if (isOverridden(key))
+        {
+            continue;
+        }
+        auto& indexes = record->isCheckConcurrent() ? concurrent : serial;
+        for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+        {
+            if (scope->containsUserValue(key))
+            {
+                indexes.append(static_cast<int>(candidates.size()));
+                candidates.append({i, scope, scope->userValue(key, record->default_value.toVariant()), Layer::User});
+            }
+        }
+        for (auto scope = this; scope != nullptr; scope = scope->m_parent)
+        {
+            if (scope->m_system_settings && scope->m_system_settings->contains(key))
+            {
+                indexes.append(static_cast<int>(candidates.size()));
+                candidates.append({i, scope, scope->m_system_settings->value(key), Layer::System});
+            }
+        }
+    }
+    begins.append(static_cast<int>(candidates.size()));
+
+    // 每个分片只写自己的结果，不需要加锁
+    constexpr int ShardSize = 64;
+    QVector<char> valid(candidates.size(), 1);
+    const auto results = valid.data(); // 先分离，工作线程中不再调用非 const 接口
+    const auto shard_count = static_cast<int>((concurrent.size() + ShardSize - 1) / ShardSize);
+    parallelFor(shard_count, s_parallelism, [&reloads, &candidates, &concurrent, results](int shard) {
+        const auto end = std::min(static_cast<int>(concurrent.size()), (shard + 1) * ShardSize);
+        for (auto i = shard * ShardSize; i < end; ++i)
+        {
+            const auto& candidate = candidates.at(concurrent.at(i));
+            results[concurrent.at(i)] = reloads.at(candidate.reload).record->check(candidate.value);
+        }
+    });
+    for (const auto index : std::as_const(serial))
+    {
+        const auto& candidate = candidates.at(index);
+        valid[index] = reloads.at(candidate.reload).record->check(candidate.value);
+    }
+
+    // 每个键取第一个合法的值，之前的非法用户值和 resolveEntry 一样删除
+    for (auto i = 0; i < reloads.size(); ++i)
+    {
+        const auto& key = reloads.at(i).key;
+        const auto& record = reloads.at(i).record;
+        if (isOverridden(key))
+        {
+            continue;
+        }
+        CacheEntry entry{record, record->default_value, Layer::Default};
+        for (auto j = begins.at(i); j < begins.at(i + 1); ++j)
+        {
+            const auto& candidate = candidates.at(j);
+            if (valid.at(j))
+            {
+                entry = {record, candidate.value, candidate.layer};
+                break;
+            }
+            LZL_SETTINGS_STATS_INC(record->stats.check_failures);
+            if (candidate.layer == Layer::User)
+            {
+                candidate.scope->beginSharedWrite();
+                candidate.scope->removeUserValue(key);
+                candidate.scope->endSharedWrite({key});
+            }
+        }
+        m_cache.insert(key, std::move(entry));
+    }
+}
+
+void Settings::Scope::beginSharedWrite()
+{
+    if (m_shared && m_shared->depth++ == 0)
+    {
+        m_shared->lock();
+    }
+}
+
+void Settings::Scope::endSharedWrite(const QStringList& keys, bool reload_all)
+{
+    if (!m_shared)
+    {
+        return;
+    }
+    m_shared->pending_keys.append(keys);
+    m_shared->pending_all = m_shared->pending_all || reload_all;
+    if (--m_shared->depth > 0)
+    {
+        return;
+    }
+    // 先写入文件再发布，其他进程看到新的计数时文件已经是新的；QSettings 同步时只写入自己修改过的键
+    settings().sync();
+    m_shared->publish(std::exchange(m_shared->pending_keys, {}), std::exchange(m_shared->pending_all, false));
+    m_shared->unlock();
+}
+
+bool Settings::Scope::isOverridden(const QString& key) const
+{
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
     {
-        if (auto data_it = group->dataset.find({name}); data_it != group->dataset.end())
+        if (scope->m_overrides.contains(key))
         {
-            return &(data_it.value());
+            return true;
         }
     }
-    return nullptr;
+    return false;
 }
 
-Settings::RegGroup* Settings::RegGroup::findGroup(const QString& dir)
+QByteArray Settings::Scope::schemaHash()
 {
-    return findGroup(detachPath(dir));
+    auto keys = visibleKeys();
+    keys.sort();
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    for (const auto& key : std::as_const(keys))
+    {
+        stream << key << findRecord(key)->default_value.toVariant();
+    }
+    return QCryptographicHash::hash(buffer, QCryptographicHash::Sha1);
 }
 
-Settings::RegGroup* Settings::RegGroup::findGroup(const QStringList& words)
+QByteArray Settings::Scope::fileStamps() const
 {
-    // 从根节点开始查找
-    auto group = this;
-    for (const auto& word : words)
+    QByteArray buffer;
+    QDataStream stream(&buffer, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    const auto stamp = [&stream](const QString& file_path) {
+        const QFileInfo info(file_path);
+        stream << info.absoluteFilePath() << (info.exists() ? info.size() : qint64(-1))
+               << (info.exists() ? info.lastModified().toMSecsSinceEpoch() : qint64(-1));
+    };
+    for (auto scope = this; scope != nullptr; scope = scope->m_parent)
     {
-        auto group_it = group->groupset.find(word);
-        if (group_it == group->groupset.end())
-        {
-            return nullptr;
-        }
-        group = &group_it.value();
+        stamp(scope->m_file_name);
+        stamp(scope->m_system_settings ? scope->m_system_settings->fileName() : QString());
     }
-    return group; // group 是最后一个有效节点
+    return buffer;
 }
 
-void Settings::RegGroup::insertData(const QString& key, const QVariant& default_value, CheckFunction check_func)
+bool Settings::Scope::covers(const Scope* scope) const
 {
-    Q_ASSERT(!key.isEmpty());
-
-    // 查找组
-    auto [words, name] = parsePath(key);
-    auto group = this;
-    for (const auto& word : std::as_const(words))
+    for (; scope != nullptr; scope = scope->m_parent)
     {
-        group = &(group->groupset[word]);
+        if (scope == this)
+        {
+            return true;
+        }
     }
-
-    Q_ASSERT_X(
-        !group->dataset.contains({name}),
-        Q_FUNC_INFO,
-        QStringLiteral("Setting registration `record` already exists: %1").arg(key).toUtf8().constData()
-    );
-    Q_ASSERT_X(
-        check_func(default_value),
-        Q_FUNC_INFO,
-        QStringLiteral("Setting default value check failed: %1").arg(key).toUtf8().constData()
-    );
-
-    // 插入数据
-    group->dataset.insert(name, {default_value, std::move(check_func)});
+    return false;
 }
 
-void Settings::RegGroup::removeData(const QString& key)
+QList<Settings::ConnId> Settings::Scope::filterConns(const QList<ConnId>& conn_ids) const
 {
-    Q_ASSERT(!key.isEmpty());
-
-    // 查找组
-    QList<RegGroup*> groups = {this};
-    auto [words, name] = parsePath(key);
-    for (const auto& word : std::as_const(words))
+    QList<ConnId> result;
+    for (const auto id : conn_ids)
     {
-        groups.append(&(groups.last()->groupset[word]));
+        if (auto it = s_conns.constFind(id); it != s_conns.cend() && covers(it->scope))
+        {
+            result.append(id);
+        }
     }
+    return result;
+}
 
-    auto group = groups.takeLast();
-    Q_ASSERT_X(
-        group->dataset.contains({name}),
-        Q_FUNC_INFO,
-        QStringLiteral("Setting registration `record` not found: %1").arg(key).toUtf8().constData()
-    );
-
-    // 删除数据
-    group->dataset.remove({name});
-
-    // 清除空节点
-    while (!groups.isEmpty() && group->dataset.isEmpty() && group->groupset.isEmpty())
+void Settings::Scope::invalidateKey(const QString& key)
+{
+    m_cache.remove(key);
+    for (auto child : std::as_const(m_children))
     {
-        Q_ASSERT(words.size() == groups.size());
-        group = groups.takeLast();
-        group->groupset.remove(words.takeLast());
+        child->invalidateKey(key);
     }
 }
 
-void Settings::RegGroup::removeGroup(const QString& dir)
+void Settings::Scope::invalidatePath(const QString& path)
 {
-    Q_ASSERT(!dir.isEmpty());
-
-    // 查找组
-    QList<RegGroup*> groups = {this};
-    auto [pre_words, group_name] = parsePath(dir);
-    for (const auto& word : std::as_const(pre_words))
+    if (path.isEmpty())
     {
-        groups.append(&groups.last()->groupset[word]);
+        m_cache.clear();
     }
-
-    auto group = groups.takeLast();
-    Q_ASSERT_X(
-        group->groupset.contains(group_name),
-        Q_FUNC_INFO,
-        QStringLiteral("Setting registration `group` not found: %1").arg(dir).toUtf8().constData()
-    );
-
-    // 删除组
-    group->groupset.remove(group_name);
-
-    // 清除空节点
-    while (!groups.isEmpty() && group->dataset.isEmpty() && group->groupset.isEmpty())
+    else
     {
-        group = groups.takeLast();
-        group->groupset.remove(pre_words.takeLast());
+        const auto prefix = path + QLatin1Char('/');
+        for (auto it = m_cache.begin(); it != m_cache.end();)
+        {
+            if (it.key() == path || it.key().startsWith(prefix))
+            {
+                it = m_cache.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    for (auto child : std::as_const(m_children))
+    {
+        child->invalidatePath(path);
     }
 }
 
-// 注册表相关类的静态
+// 主类静态辅助函数的实现
 /* ========================================================================== */
 
-QStringList Settings::RegGroup::detachPath(const QString& path)
-{
-    // 如果 path 为空，返回空列表
-    static const QRegularExpression re(QStringLiteral(R"([/\\])"));
-#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
-    return path.split(re, Qt::SkipEmptyParts);
-#else
-    return path.split(re, QString::SkipEmptyParts);
-#endif
-}
+QMap<Settings::ConnId, Settings::ConnFunctions> Settings::s_conns = {};
+QList<Settings::ConnId> Settings::s_emit_queue = {};
+QSet<Settings::ConnId> Settings::s_emit_pending = {};
+bool Settings::s_emit_draining = false;
+QList<Settings::DeferredEmit> Settings::s_deferred_queue = {};
+QHash<Settings::ConnId, QStringList> Settings::s_deferred_keys = {};
+int Settings::s_deferred_budget = 8;
+bool Settings::s_deferred_scheduled = false;
+Settings::PatternNode Settings::s_patterns = {};
+QHash<Settings::ConnId, QStringList> Settings::s_emit_keys = {};
+QHash<QString, Settings::ValueChange> Settings::s_emit_changes = {};
 
-Settings::RegGroup::ParsedPathPair Settings::RegGroup::parsePath(const QString& path)
+Settings::ConnId Settings::generateId()
 {
-    // 如果 path 为空，返回空列表和空字符串
-    auto words = detachPath(path);
-    auto name = words.isEmpty() ? QString() : words.takeLast();
-    return {words, name};
+    static ConnId id;
+    do
+    {
+        ++id;
+    } while (id.isNull() || s_conns.contains(id));
+    return id; // 理论上不会轮回到 0
 }
 
-// 主类的静态（对外接口）函数实现
-/* ========================================================================== */
-
-bool Settings::writeValue(const QString& key, const QVariant& value, bool emit_signal)
+Settings::ConnId Settings::insertConn(
+    Scope* scope,
+    const QString& key,
+    const std::shared_ptr<const RegData>& data,
+    std::function<void(void)>&& read_func
+)
 {
-    Q_ASSERT(!key.isEmpty());
-
-    // 如果数据符合检查
-    if (instance().findRecord(key)->check_func(value))
-    {
-        instance().m_q_settings.setValue(key, value);
-        if (emit_signal)
-        {
-            emitReadValuesFromKey(key);
-        }
-        return true;
-    }
-    return false;
+    auto id = generateId();
+    data->conn_ids.append(id);
+    auto& conn = s_conns[id];
+    conn.read = std::make_shared<const std::function<void(void)>>(std::move(read_func));
+    // 持有记录，即使它已经不在当前快照中
+    conn.disconnect = [data, id]() { data->conn_ids.removeOne(id); };
+    conn.scope = scope;
+#ifdef LZL_QT_SETTINGS_STATS
+    conn.data = data.get();
+#endif
+#ifdef LZL_QT_SETTINGS_TRACE
+    conn.key = key;
+#else
+    Q_UNUSED(key);
+#endif
+    return id;
 }
 
-void Settings::disconnectReadValue(ConnId id)
+void Settings::bindReceiver(ConnId id, const QObject* receiver)
 {
-    Q_ASSERT(!id.isNull());
+    Q_ASSERT(receiver != nullptr);
+    auto it = s_conns.find(id);
     Q_ASSERT_X(
-        s_conns.contains(id),
+        it != s_conns.end(),
         Q_FUNC_INFO,
         QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
     );
-    s_conns.take(id).disconnect();
-}
-
-void Settings::disconnectReadValuesFromKey(const QString& key)
-{
-    Q_ASSERT(!key.isEmpty());
-    instance().findRecord(key)->clearConns();
+    // 解绑时断开连接，因此回调执行时读取事件一定还存在
+    const auto connection = QObject::connect(receiver, &QObject::destroyed, [id]() { disconnectReadValue(id); });
+    it->receiver = std::shared_ptr<const QMetaObject::Connection>(
+        new QMetaObject::Connection(connection),
+        [](const QMetaObject::Connection* connection) {
+            QObject::disconnect(*connection);
+            delete connection;
+        }
+    );
 }
 
-void Settings::disconnectReadValuesFromGroup(const QString& dir)
+void Settings::invokeConn(ConnId id, ConnFunctions& conn)
 {
-    Q_ASSERT(!dir.isEmpty());
+    LZL_SETTINGS_TRACE_SCOPE("emitReadValue", conn.key, static_cast<std::size_t>(id));
+    const auto read = conn.read;
+#ifdef LZL_QT_SETTINGS_STATS
+    // 模式订阅没有对应的记录
+    if (conn.data != nullptr)
+    {
+        LZL_SETTINGS_STATS_INC(conn.data->stats.emits);
+    }
+    QElapsedTimer timer;
+    timer.start();
+    (*read)();
+    const auto ns = timer.nsecsElapsed();
 
-    auto group = instance().findRegGroup(dir);
-    for (const auto& data : std::as_const(group->dataset))
+    // 回调中可能解绑了自己，因此需要重新查找
+    auto it = s_conns.find(id);
+    if (it == s_conns.end())
+    {
+        return;
+    }
+    auto& stats = it->stats;
+    std::size_t bucket = 0;
+    for (auto us = ns / 1000; us > 0 && bucket < ConnStats::HistogramSize - 1; us >>= 1)
     {
-        data.clearConns();
+        ++bucket;
     }
+    ++stats.calls;
+    stats.total_ns += ns;
+    stats.max_ns = std::max(stats.max_ns, ns);
+    ++stats.latency_histogram[bucket];
+#else
+    Q_UNUSED(id);
+    (*read)();
+#endif
 }
 
-void Settings::disconnectAllSettingsReadValues()
+void Settings::drainEmits()
 {
-    for (auto it = s_conns.begin(); it != s_conns.end(); it = s_conns.erase(it))
+    s_emit_draining = true;
+    // 回调抛出异常时丢弃剩余事件，保证之后可以继续触发
+    const auto guard = qScopeGuard([] {
+        s_emit_queue.clear();
+        s_emit_pending.clear();
+        s_emit_keys.clear();
+        s_emit_changes.clear();
+        s_emit_draining = false;
+    });
+
+    for (int cycle = 0; !s_emit_queue.isEmpty(); ++cycle)
     {
-        it.value().disconnect();
+        if (cycle == MaxEmitCycles)
+        {
+            qWarning(
+                "lzl::utils::Settings: emit cascade exceeded %d cycles, %d pending read events dropped.",
+                MaxEmitCycles,
+                static_cast<int>(s_emit_queue.size())
+            );
+            break;
+        }
+        // 本轮执行期间新触发的事件进入下一轮
+        const auto batch = std::exchange(s_emit_queue, {});
+        for (const auto id : batch)
+        {
+            s_emit_pending.remove(id);
+            // 可能已经在之前的回调中解绑
+            if (auto it = s_conns.find(id); it != s_conns.end())
+            {
+                invokeConn(id, it.value());
+            }
+        }
     }
 }
 
-void Settings::emitReadValue(ConnId id)
+void Settings::deferEmits(const QList<ConnId>& ids, const QHash<ConnId, QStringList>& pattern_keys, int priority)
 {
-    Q_ASSERT_X(
-        s_conns.contains(id),
-        Q_FUNC_INFO,
-        QStringLiteral("Connection not found id: %1").arg(static_cast<std::size_t>(id)).toUtf8().constData()
+    auto append = [priority](ConnId id, const QStringList& keys) {
+        // 已经在等待中的事件只合并键，执行时会读取最新值
+        if (auto it = s_deferred_keys.find(id); it != s_deferred_keys.end())
+        {
+            for (const auto& key : keys)
+            {
+                if (!it->contains(key))
+                {
+                    it->append(key);
+                }
+            }
+            return;
+        }
+        s_deferred_keys.insert(id, keys);
+        s_deferred_queue.append({id, priority});
+    };
+    for (const auto id : ids)
+    {
+        append(id, {});
+    }
+    for (auto it = pattern_keys.cbegin(); it != pattern_keys.cend(); ++it)
+    {
+        append(it.key(), it.value());
+    }
+    // 稳定排序，同样优先级的事件保持触发的顺序
+    const auto conn_priority = [](ConnId id) {
+        const auto it = s_conns.constFind(id);
+        return it != s_conns.cend() ? it->priority : 0;
+    };
+    std::stable_sort(
+        s_deferred_queue.begin(),
+        s_deferred_queue.end(),
+        [&conn_priority](const DeferredEmit& a, const DeferredEmit& b) {
+            if (a.priority != b.priority)
+            {
+                return a.priority > b.priority;
+            }
+            return conn_priority(a.id) > conn_priority(b.id);
+        }
     );
-    s_conns[id].read();
-}
 
-void Settings::emitReadValues(const QList<ConnId>& ids)
-{
-    for (const auto id : ids)
+    if (!s_deferred_scheduled && !s_deferred_queue.isEmpty())
     {
-        emitReadValue(id);
+        s_deferred_scheduled = true;
+        QTimer::singleShot(0, &Settings::runDeferredEmits);
     }
 }
 
-void Settings::emitReadValuesFromKey(const QString& key)
+void Settings::runDeferredEmits()
 {
-    emitReadValues(getConnIdsFromKey(key));
-}
+    s_deferred_scheduled = false;
+    if (s_deferred_queue.isEmpty())
+    {
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    // 至少执行一个事件，保证在回调很慢时也能向前推进
+    do
+    {
+        const auto id = s_deferred_queue.takeFirst().id;
+        auto keys = s_deferred_keys.take(id);
+        // 可能在等待期间已经解绑
+        if (!s_conns.contains(id))
+        {
+            continue;
+        }
+        if (!keys.isEmpty())
+        {
+            auto& pending = s_emit_keys[id];
+            for (const auto& key : std::as_const(keys))
+            {
+                if (!pending.contains(key))
+                {
+                    pending.append(key);
+                }
+            }
+        }
+        emitReadValues({id});
+    } while (!s_deferred_queue.isEmpty() && !timer.hasExpired(s_deferred_budget));
 
-void Settings::emitReadValuesFromGroup(const QString& dir)
-{
-    emitReadValues(getConnIdsFromGroup(dir));
+    if (!s_deferred_queue.isEmpty())
+    {
+        s_deferred_scheduled = true;
+        QTimer::singleShot(0, &Settings::runDeferredEmits);
+    }
 }
 
-void Settings::emitAllSettingsReadValues()
+void Settings::removePatternConn(const QStringList& words, ConnId id)
 {
-    for (const auto& conn_func : std::as_const(s_conns))
+    // 记录路径上的节点以便清除空节点
+    QList<PatternNode*> nodes = {&s_patterns};
+    QList<SegmentId> ids;
+    for (const auto& word : words)
     {
-        conn_func.read();
+        ids.append(findSegment(word));
+        auto child = nodes.last()->children.value(ids.last());
+        Q_ASSERT(child != nullptr);
+        nodes.append(child.get());
     }
-}
+    nodes.last()->conn_ids.removeOne(id);
 
-QList<Settings::ConnId> Settings::getConnIdsFromKey(const QString& key)
-{
-    Q_ASSERT(!key.isEmpty());
-    // 在 findRecord 中 Q_ASSERT_X 会确保 record 不为空
-    return instance().findRecord(key)->conn_ids;
+    // 清除空节点
+    while (nodes.size() > 1 && nodes.last()->conn_ids.isEmpty() && nodes.last()->children.isEmpty())
+    {
+        nodes.removeLast();
+        nodes.last()->children.remove(ids.takeLast());
+    }
 }
 
-QList<Settings::ConnId> Settings::getConnIdsFromGroup(const QString& dir)
+QList<Settings::ConnId> Settings::matchPatterns(const QString& key)
 {
-    Q_ASSERT(!dir.isEmpty());
+    if (s_patterns.children.isEmpty())
+    {
+        return {};
+    }
+    // 没有驻留过的段为 0，只能被通配符匹配
+    QVector<SegmentId> words;
+    for (const auto& word : RegGroup::detachPath(key))
+    {
+        words.append(findSegment(word));
+    }
     QList<ConnId> conn_ids;
-    // 在 findRegGroup 中 Q_ASSERT_X 会确保 group 不为空
-    getConnIdsFromGroup(instance().findRegGroup(dir), conn_ids);
+    matchPatterns(&s_patterns, words, 0, conn_ids);
+    // 同一个模式可能通过多条路径匹配
     std::sort(conn_ids.begin(), conn_ids.end());
+    conn_ids.erase(std::unique(conn_ids.begin(), conn_ids.end()), conn_ids.end());
     return conn_ids;
 }
 
-// 主类的辅助函数的实现
-/* ========================================================================== */
-
-Settings::RegData* Settings::findRecord(const QString& key)
-{
-    auto data = m_regedit.findData(key);
-    Q_ASSERT_X(
-        data != nullptr,
-        Q_FUNC_INFO,
-        QStringLiteral("Setting registration `record` not found: %1").arg(key).toUtf8().constData()
-    );
-    return data;
-}
-
-Settings::RegGroup* Settings::findRegGroup(const QString& dir)
-{
-    auto group = m_regedit.findGroup(dir);
-    Q_ASSERT_X(
-        group != nullptr,
-        Q_FUNC_INFO,
-        QStringLiteral("Setting registration `group` not found: %1").arg(dir).toUtf8().constData()
-    );
-    return group;
-}
-
-QVariant Settings::getValue(const QString& key)
+bool Settings::matchPattern(const QStringList& pattern, const QStringList& words)
 {
-    auto record = findRecord(key);
-    if (auto value = m_q_settings.value(key, record->default_value); record->check_func(value))
+    if (pattern.isEmpty())
     {
-        return value;
+        return words.isEmpty();
+    }
+    const auto& head = pattern.first();
+    if (head == QLatin1String("**"))
+    {
+        // 匹配零段，或者匹配一段后继续作为 **
+        return matchPattern(pattern.mid(1), words) || (!words.isEmpty() && matchPattern(pattern, words.mid(1)));
     }
-    // 重置非法值
-    m_q_settings.setValue(key, record->default_value);
-    return record->default_value;
+    return !words.isEmpty() && (head == QLatin1String("*") || head == words.first())
+        && matchPattern(pattern.mid(1), words.mid(1));
 }
 
-// 主类静态辅助函数的实现
 /* ========================================================================== */
 
-QMap<Settings::ConnId, Settings::ConnFunctions> Settings::s_conns = {};
-
-Settings::ConnId Settings::generateId()
+void Settings::getConnIdsFromGroup(const RegGroup* group, QList<ConnId>& conn_ids)
 {
-    static ConnId id;
-    do
+    // 读取数据
+    for (auto i = 0; i < group->dataset.size(); ++i)
     {
-        ++id;
-    } while (id.isNull() || s_conns.contains(id));
-    return id; // 理论上不会轮回到 0
+        for (const auto conn_id : group->dataset.valueAt(i)->conn_ids)
+        {
+            conn_ids.append(conn_id);
+        }
+    }
+    // 递归读取子组
+    for (auto i = 0; i < group->groupset.size(); ++i)
+    {
+        getConnIdsFromGroup(group->groupset.valueAt(i).get(), conn_ids);
+    }
 }
 
-Settings::ConnId Settings::insertConn(const RegData* data, std::function<void(void)>&& read_func)
+void Settings::matchPatterns(
+    const PatternNode* node, const QVector<SegmentId>& words, int index, QList<ConnId>& conn_ids
+)
 {
-    auto id = generateId();
-    data->conn_ids.append(id);
-    s_conns[id] = {
-        std::move(read_func),
-        [data, id]() { data->conn_ids.removeOne(id); },
-    };
-    return id;
+    // ** 匹配零或多段
+    static const auto any_deep = internSegment(QStringLiteral("**"));
+    static const auto any = internSegment(QStringLiteral("*"));
+    if (auto child = node->children.value(any_deep); child != nullptr)
+    {
+        for (auto i = index; i <= words.size(); ++i)
+        {
+            matchPatterns(child.get(), words, i, conn_ids);
+        }
+    }
+    if (index == words.size())
+    {
+        conn_ids.append(node->conn_ids);
+        return;
+    }
+    if (auto child = node->children.value(words.at(index)); child != nullptr)
+    {
+        matchPatterns(child.get(), words, index + 1, conn_ids);
+    }
+    if (auto child = node->children.value(any); child != nullptr)
+    {
+        matchPatterns(child.get(), words, index + 1, conn_ids);
+    }
 }
 
-/* ========================================================================== */
-
-void Settings::getConnIdsFromGroup(const RegGroup* group, QList<ConnId>& conn_ids)
+#ifdef LZL_QT_SETTINGS_STATS
+void Settings::collectStats(const RegGroup* group, const QString& dir, Stats& stats)
 {
+    const auto join = [&dir](const QString& name) { return dir.isEmpty() ? name : dir + QLatin1Char('/') + name; };
     // 读取数据
-    for (const auto& data : std::as_const(group->dataset))
+    for (auto i = 0; i < group->dataset.size(); ++i)
     {
-        for (const auto conn_id : data.conn_ids)
+        const auto key = join(segmentName(group->dataset.keyAt(i)));
+        const auto& data = group->dataset.valueAt(i);
+        stats.keys.insert(key, data->stats);
+        for (const auto conn_id : data->conn_ids)
         {
-            conn_ids.append(conn_id);
+            auto conn_stats = s_conns.value(conn_id).stats;
+            conn_stats.key = key;
+            stats.conns.insert(conn_id, conn_stats);
         }
     }
     // 递归读取子组
-    for (const auto& sub_group : std::as_const(group->groupset))
+    for (auto i = 0; i < group->groupset.size(); ++i)
     {
-        getConnIdsFromGroup(&sub_group, conn_ids);
+        collectStats(group->groupset.valueAt(i).get(), join(segmentName(group->groupset.keyAt(i))), stats);
     }
 }
 
+void Settings::resetStats(const RegGroup* group)
+{
+    for (auto i = 0; i < group->dataset.size(); ++i)
+    {
+        group->dataset.valueAt(i)->stats = {};
+    }
+    for (auto i = 0; i < group->groupset.size(); ++i)
+    {
+        resetStats(group->groupset.valueAt(i).get());
+    }
+}
+#endif
+
 } // namespace lzl::utils
@@ -13,9 +13,24 @@
 #include "lzl_convert_qt_variant.h"
 #include "lzl_lib_settings_exports.h"
 
+#include <QFuture>
+#include <QHash>
 #include <QMap>
+#include <QMutex>
 #include <QSet>
 #include <QSettings>
+#include <QVector>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#if defined(__cpp_impl_coroutine) && QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    #include <coroutine>
+#endif
+
+QT_FORWARD_DECLARE_CLASS(QIODevice)
 
 namespace lzl::utils {
 
@@ -31,6 +46,7 @@ namespace lzl::utils {
  */
 class LZL_QT_SETTINGS_EXPORT Settings final
 {
+    Settings() = delete;
     Settings(const Settings&) = delete;
     Settings& operator=(const Settings&) = delete;
     Settings(Settings&&) = delete;
@@ -65,6 +81,93 @@ public:
         ConnId& operator++() noexcept { return ++m_id, *this; }
     };
 
+    /**
+     * @brief KeyStats 键的统计数据
+     * @note 只有定义了 LZL_QT_SETTINGS_STATS 才会统计，否则全部为 0
+     */
+    struct KeyStats final
+    {
+        quint64 reads = 0;          // 读取次数
+        quint64 writes = 0;         // 写入成功次数
+        quint64 check_failures = 0; // 检查失败次数（写入被拒绝或读取时重置非法值）
+        quint64 cache_hits = 0;     // 读取命中缓存的次数
+        quint64 emits = 0;          // 触发读取事件的次数
+    };
+
+    /**
+     * @brief ConnStats 读取事件的统计数据
+     * @note latency_histogram[i] 为耗时在 [2^(i-1), 2^i) 微秒的次数，第 0 个为小于 1 微秒，最后一个包含所有更大的
+     */
+    struct ConnStats final
+    {
+        static constexpr std::size_t HistogramSize = 16;
+
+        QString key = {};
+        quint64 calls = 0;
+        qint64 total_ns = 0;
+        qint64 max_ns = 0;
+        std::array<quint64, HistogramSize> latency_histogram = {};
+    };
+
+    /**
+     * @brief Stats 统计数据的快照
+     */
+    struct Stats final
+    {
+        QMap<QString, KeyStats> keys;
+        QMap<ConnId, ConnStats> conns;
+    };
+
+    /**
+     * @brief Layer 设置值的来源，优先级从低到高
+     */
+    enum class Layer
+    {
+        Default,  // 注册时的默认值
+        System,   // 只读的系统设置文件
+        User,     // 设置文件（可写）
+        Override, // 运行时覆盖，如命令行参数、环境变量
+    };
+
+    /**
+     * @brief ExportFormat 导出和导入的格式
+     */
+    enum class ExportFormat
+    {
+        Json,   // JSON Lines：每行一个 {"key": ..., "value": ...}，其他类型按 QSettings 的写法编码为字符串
+        Binary, // QDataStream 序列化，保留 QVariant 的类型
+    };
+
+    /**
+     * @brief HistoryEntry 设置的一条历史记录
+     */
+    struct HistoryEntry final
+    {
+        qint64 timestamp = 0; // 毫秒时间戳，见 QDateTime::currentMSecsSinceEpoch
+        QVariant value = {};
+        Layer source = Layer::Default; // 值来自哪一层
+    };
+
+    /**
+     * @brief ValidationIssue 批量检查中发现的非法值
+     */
+    struct ValidationIssue final
+    {
+        QString key = {};
+        QVariant value = {};
+        Layer layer = Layer::User; // 设置文件中的非法值会被删除，系统设置文件是只读的，只报告
+    };
+
+    /**
+     * @brief Scope 设置的作用域，拥有独立的设置文件和注册表，定义见下方
+     */
+    class Scope;
+
+    /**
+     * @brief Broker 本地设置代理，为多个进程提供同一份设置，定义见下方
+     */
+    class Broker;
+
     /**
      * @brief InitIniDirectory 设置设置文件的目录
      * @param directory 目录路径
@@ -79,57 +182,266 @@ public:
      */
     static void InitIniFilePath(const QString& file_path);
 
+    /**
+     * @brief setSystemIniFile 设置只读的系统设置文件，优先级低于设置文件，高于默认值
+     * @param file_path 文件完整路径，为空则移除
+     */
+    static void setSystemIniFile(const QString& file_path);
+
+    /**
+     * @brief setOverride 设置运行时覆盖的值，优先级最高且不会写入设置文件
+     * @param key 注册过的键，不可为空
+     * @param value 覆盖的值
+     * @param emit_signal 是否触发读取事件信号
+     * @return 是否通过检查
+     */
+    static bool setOverride(const QString& key, const QVariant& value, bool emit_signal = false);
+
+    /**
+     * @brief removeOverride 移除运行时覆盖的值
+     * @param key 注册过的键，不可为空
+     * @param emit_signal 是否触发读取事件信号
+     */
+    static void removeOverride(const QString& key, bool emit_signal = false);
+
+    /**
+     * @brief clearOverrides 移除所有运行时覆盖的值
+     */
+    static void clearOverrides();
+
+    /**
+     * @brief loadOverridesFromArguments 从命令行参数加载运行时覆盖的值
+     * @param arguments 命令行参数，支持 `--set key=value` 和 `--set=key=value`
+     * @param option 选项名
+     * @return 成功加载的数量，未注册或检查失败的会被忽略并警告
+     * @note 文本会尽量转换为默认值的类型
+     */
+    static int loadOverridesFromArguments(
+        const QStringList& arguments, const QString& option = QStringLiteral("--set")
+    );
+
+    /**
+     * @brief loadOverridesFromEnvironment 从环境变量加载运行时覆盖的值
+     * @param prefix 环境变量前缀，如 MYAPP_ 时 app/font/size 对应 MYAPP_APP_FONT_SIZE
+     * @return 成功加载的数量，检查失败的会被忽略并警告
+     * @note 文本会尽量转换为默认值的类型
+     */
+    static int loadOverridesFromEnvironment(const QString& prefix);
+
+    /**
+     * @brief effectiveLayer 获取设置当前值的来源
+     * @param key 注册过的键，不可为空
+     * @return 当前值来自哪一层
+     */
+    [[nodiscard]] static Layer effectiveLayer(const QString& key);
+
+    /**
+     * @brief loadStartupCache 加载启动缓存，命中时首次读取不需要解析设置文件，也不会执行检查函数
+     * @param cache_path 缓存文件的路径
+     * @return 是否命中，注册表（键和默认值）或设置文件有任何变化都不会命中
+     * @note 应该在注册完所有设置之后、首次读取之前调用；检查函数无法序列化，修改检查函数后应删除缓存
+     */
+    static bool loadStartupCache(const QString& cache_path);
+
+    /**
+     * @brief saveStartupCache 保存启动缓存，包括注册表的摘要和所有设置当前的值（运行时覆盖的除外）
+     * @param cache_path 缓存文件的路径
+     * @return 是否保存成功
+     * @note 值需要能通过 QDataStream 序列化
+     */
+    static bool saveStartupCache(const QString& cache_path);
+
+    /**
+     * @brief setHistoryCapacity 设置之后注册的设置保留多少条历史记录
+     * @param capacity 每个设置的历史记录容量，为 0 则不记录（默认）
+     * @note 容量在注册时一次分配，之后写入不再分配；满了之后覆盖最旧的记录
+     */
+    static void setHistoryCapacity(int capacity);
+
+    /**
+     * @brief setParallelism 设置批量操作（导出的序列化、批量检查、重新读取后的检查）最多使用的线程数
+     * @param threads 线程数，为 0 则使用 QThread::idealThreadCount()（默认），为 1 则在当前线程中串行执行
+     * @note 工作线程来自 QThreadPool::globalInstance()，当前线程也参与执行；回调和设置文件只在当前线程中访问
+     */
+    static void setParallelism(int threads);
+
+    /**
+     * @brief history 获取设置的历史记录
+     * @param key 注册过的键，不可为空
+     * @return 从旧到新的历史记录，第一条是第一次修改之前的值（时间为注册时间）
+     * @note 通过 writeValue、setOverride、removeOverride、clearOverrides 和回滚修改当前值时记录，
+     *       通过任意作用域的修改都记录在注册的记录中；reset 和 sync 不记录
+     */
+    [[nodiscard]] static QList<HistoryEntry> history(const QString& key);
+
+    /**
+     * @brief rollbackKey 将设置回滚到某个时间点的值
+     * @param key 注册过的键，不可为空
+     * @param timestamp 毫秒时间戳，回滚到不晚于它的最后一条记录
+     * @param emit_signal 是否触发读取事件信号
+     * @return 是否修改了值，没有记录、值相同或写入失败（如代理断开）时返回 false
+     * @note 值会写回它原来所在的层：运行时覆盖、设置文件，或者移除设置文件中的值以使用系统设置和默认值
+     */
+    static bool rollbackKey(const QString& key, qint64 timestamp, bool emit_signal = false);
+
+    /**
+     * @brief rollbackGroup 将组中的所有设置回滚到某个时间点的值
+     * @param dir 存在的组，不可为空
+     * @param timestamp 毫秒时间戳
+     * @param emit_signal 是否触发读取事件信号，所有修改完成后只触发一次
+     * @return 修改的设置数量，写入失败（如代理断开）的键不计入
+     */
+    static int rollbackGroup(const QString& dir, qint64 timestamp, bool emit_signal = false);
+
+    /**
+     * @brief validateAll 检查所有设置文件和系统设置文件中的值，删除设置文件中的非法值
+     * @param parallelism 最多使用的线程数，为 0 则使用 setParallelism 的设置
+     * @param emit_signal 是否触发读取事件信号，所有修改完成后只触发一次
+     * @return 发现的非法值
+     * @note 在当前线程中读取值的快照，检查函数在多个线程中并行调用（注册时声明不能并行的除外）；
+     *       所有删除作为一次写入，而不是在读取时逐个发现并修复
+     */
+    static QList<ValidationIssue> validateAll(int parallelism = 0, bool emit_signal = false);
+
+    /**
+     * @brief exportGroup 将组中所有设置的当前值流式写入设备
+     * @param dir 组的路径，为空则导出所有设置
+     * @param device 已经以写入方式打开的设备
+     * @param format 格式
+     * @return 导出的数量，写入失败返回 -1
+     * @note 键相对于组，按分片写入而不是先生成完整的文档；被运行时覆盖的键导出覆盖之前的值。
+     *       值在当前线程中读取，序列化在多个线程中按分片并行（见 setParallelism），输出的顺序不变
+     */
+    static int exportGroup(const QString& dir, QIODevice* device, ExportFormat format = ExportFormat::Json);
+
+    /**
+     * @brief importGroup 从设备流式读取设置并写入组中
+     * @param dir 组的路径，为空则是根
+     * @param device 已经以读取方式打开的设备
+     * @param format 格式
+     * @param emit_signal 是否触发读取事件信号，全部写入后只触发一次
+     * @return 写入的数量，格式错误时返回 -1，不写入任何条目；写入失败（如代理断开）时停止，返回已经写入的数量
+     * @note 先读取所有条目并通过检查函数检查，再作为一次写入；未注册或检查失败的条目会被忽略并警告；
+     *       值会尽量转换为默认值的类型。可以回到开头的设备（如文件）读取两遍，第二遍按窗口写入，
+     *       内存中只有一个窗口的值；顺序设备（如套接字）只能读取一遍，所有条目会暂存在内存中
+     */
+    static int importGroup(
+        const QString& dir, QIODevice* device, ExportFormat format = ExportFormat::Json, bool emit_signal = false
+    );
+
+    /**
+     * @brief setProcessShared 开启或关闭多进程共享模式，用于多个进程同时使用同一个设置文件
+     * @param shared 是否开启
+     * @return 是否成功，无法创建或连接共享内存时返回 false
+     * @note 同一个设置文件的所有进程连接同一段共享内存，其中是一个修改计数和按键的哈希分布的每个键的修改计数；
+     *       写入时加锁并立即同步到文件，然后增加修改的键和总的计数，因此多个进程的写入不会相互覆盖
+     */
+    static bool setProcessShared(bool shared);
+
+    /**
+     * @brief isProcessShared 是否开启了多进程共享模式
+     */
+    [[nodiscard]] static bool isProcessShared();
+
+    /**
+     * @brief pollSharedChanges 检查其他进程的修改，重新读取修改过的键
+     * @param emit_signal 是否对值发生变化的键触发读取事件信号，全部读取后只触发一次
+     * @return 值发生变化的键的数量
+     * @note 只比较一个计数，没有修改时不加锁也不读取文件，可以用 QTimer 频繁调用；未开启共享模式时返回 0
+     */
+    static int pollSharedChanges(bool emit_signal = false);
+
+    /**
+     * @brief brokerEnabled 是否编译了本地设置代理
+     * @return 是否定义了 LZL_QT_SETTINGS_BROKER
+     */
+    [[nodiscard]] static constexpr bool brokerEnabled() noexcept
+    {
+#ifdef LZL_QT_SETTINGS_BROKER
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief attachBroker 连接本地设置代理，之后设置文件这一层的读写都通过代理
+     * @param server_name 代理监听的名称，见 Broker::listen
+     * @param timeout_ms 连接并取得所有值的超时时间（毫秒）
+     * @return 是否连接成功，失败时依然使用设置文件
+     * @note 连接时一次往返取得所有值，之后读取不需要解析设置文件；写入和重置发给代理，
+     *       其他进程的修改由代理推送，在事件循环中对值变化的键触发读取事件；未编译代理时返回 false
+     * @note 代理断开后依然读取断开前的值，写入返回 false 且不修改本地的值，直到 detachBroker
+     */
+    static bool attachBroker(const QString& server_name, int timeout_ms = 3000);
+
+    /**
+     * @brief detachBroker 断开本地设置代理，重新使用设置文件
+     * @note 会等待还没有发送的写入，代理断开后保留最后的值，但不会再收到其他进程的修改
+     */
+    static void detachBroker();
+
+    /**
+     * @brief isBrokerAttached 是否连接了本地设置代理
+     */
+    [[nodiscard]] static bool isBrokerAttached();
+
+    /**
+     * @brief globalScope 全局作用域，下面所有的静态接口都作用于它
+     * @return 全局作用域，使用 InitIniDirectory/InitIniFilePath 设置的文件
+     */
+    [[nodiscard]] static Scope& globalScope() { return instance(); }
+
     /**
      * @brief sync 同步设置
      */
-    static void sync() { instance().m_q_settings.sync(); }
+    static void sync();
 
     /**
      * @brief reset 清空设置文件
      */
-    static void reset() { instance().m_q_settings.clear(); }
+    static void reset();
 
     /**
      * @brief reset 清空设置
      * @param path 键或组的路径
      */
-    static void reset(const QString& path) { instance().m_q_settings.remove(path); }
+    static void reset(const QString& path);
 
     /**
      * @brief containsKey 是否注册过设置
      * @param key 键的值
      * @return 是否注册过
      */
-    [[nodiscard]] static bool containsKey(const QString& key) { return instance().m_regedit.containsData(key); }
+    [[nodiscard]] static bool containsKey(const QString& key);
 
     /**
      * @brief containsGroup 是否存在组
      * @param dir 组的路径
      * @return 是否存在组
      */
-    [[nodiscard]] static bool containsGroup(const QString& dir) { return instance().m_regedit.containsGroup(dir); }
+    [[nodiscard]] static bool containsGroup(const QString& dir);
 
     /**
      * @brief registerSetting 注册设置
      * @param key 要注册的键，不可为空
      * @param default_value 默认值
      * @param check_func 检查默认值是否合法
+     * @param concurrent_check 检查函数是否可以在多个线程中同时调用，否则批量检查时在当前线程中串行调用
      */
     static void registerSetting(
-        const QString& key, const QVariant& default_value = {}, CheckFunction check_func = [](const QVariant&) -> bool {
-            return true;
-        }
-    )
-    {
-        instance().m_regedit.insertData(key, default_value, std::move(check_func));
-    }
+        const QString& key,
+        const QVariant& default_value = {},
+        CheckFunction check_func = [](const QVariant&) -> bool { return true; },
+        bool concurrent_check = true
+    );
 
     /**
      * @brief registerSetting 注册设置
      * @param key 要注册的键，不可为空
      * @param default_value 默认值
      * @param object 对象
-     * @param check_func 对象成员函数检查默认值是否合法
+     * @param check_func 对象成员函数检查默认值是否合法，批量检查时在当前线程中串行调用
      */
     template <typename Class>
     static void registerSetting(
@@ -140,25 +452,50 @@ public:
      * @brief deRegisterSettingKey 注销设置
      * @param key 注册过的键，不可为空
      */
-    static void deRegisterSettingKey(const QString& key) { instance().m_regedit.removeData(key); }
+    static void deRegisterSettingKey(const QString& key);
 
     /**
      * @brief deRegisterSettingGroup 注销设置
      * @param dir 存在的组，不可为空
      */
-    static void deRegisterSettingGroup(const QString& dir) { instance().m_regedit.removeGroup(dir); }
+    static void deRegisterSettingGroup(const QString& dir);
 
     /**
      * @brief deRegisterAllSettings 注销所有设置
      */
-    static void deRegisterAllSettings() { instance().m_regedit.clear(); }
+    static void deRegisterAllSettings();
+
+    /**
+     * @brief registerInstance 注册模板组的实例，之后 dir/id 下的键和注册过的键用法相同
+     * @param dir 模板组的路径，模板是用 registerSetting 注册在 dir 下名为 `*` 的组中的键
+     * @param id 实例的 id，不可为空，如文档或连接的 id
+     * @param defaults 覆盖模板默认值的键（相对于实例的路径）和值，没有覆盖的键使用模板的默认值
+     * @note 只插入一次哈希表，不修改注册表；默认值和检查函数与模板共享，实例只保存覆盖的默认值。
+     *       键绑定事件或记录历史时才创建指向模板的记录，批量读取、导出和检查不会创建
+     */
+    static void registerInstance(const QString& dir, const QString& id, const QVariantHash& defaults = {});
+
+    /**
+     * @brief deRegisterInstance 注销模板组的实例，同时断开实例中所有键的读取事件
+     * @param dir 模板组的路径
+     * @param id 注册过的实例 id
+     */
+    static void deRegisterInstance(const QString& dir, const QString& id);
+
+    /**
+     * @brief containsInstance 是否注册过模板组的实例
+     * @param dir 模板组的路径
+     * @param id 实例的 id
+     * @return 是否注册过
+     */
+    [[nodiscard]] static bool containsInstance(const QString& dir, const QString& id);
 
     /**
      * @brief writeValue 写入设置
      * @param key 注册过的键，不可为空
      * @param value 设置的值
      * @param emit_signal 是否触发读取事件信号
-     * @return 是否写入成功
+     * @return 是否写入成功，检查失败或连接的代理已经断开时返回 false
      */
     static bool writeValue(const QString& key, const QVariant& value, bool emit_signal = false);
 
@@ -179,6 +516,47 @@ public:
     template <typename Func>
     static void readValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func);
 
+    /**
+     * @brief readValueAsync 异步读取设置
+     * @param key 注册过的键，不可为空
+     * @return 转换为 T 的值，已经缓存或者设置文件已经读入时立即完成
+     * @note 设置文件还没有打开时，在工作线程中解析作用域链上所有还没有打开的设置文件，
+     *       完成后回到当前线程安装并完成所有等待中的读取，因此调用的线程需要有事件循环
+     * @note 与 readValue 一样通过 ConvertQVariant<T> 转换，T 需要有对应的特化
+     */
+    template <typename T>
+    [[nodiscard]] static QFuture<T> readValueAsync(const QString& key);
+
+    /**
+     * @brief readValuesAsync 异步读取多个设置
+     * @param keys 注册过的键
+     * @return 键和值，所有键共用一次加载；加载期间注销的键不在结果中
+     */
+    [[nodiscard]] static QFuture<QVariantHash> readValuesAsync(const QStringList& keys);
+
+#if defined(__cpp_impl_coroutine) && QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    /**
+     * @brief Awaiter 在 C++20 协程中等待异步读取，如：co_await Settings::Awaiter(Settings::readValueAsync<int>(key))
+     * @note 在完成读取的线程（作用域的线程）中恢复协程
+     */
+    template <typename T>
+    class Awaiter final
+    {
+    public:
+        explicit Awaiter(QFuture<T> future) : m_future(std::move(future)) {}
+
+        [[nodiscard]] bool await_ready() const { return m_future.isFinished(); }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            m_future.then([handle](QFuture<T>) { handle.resume(); });
+        }
+        T await_resume() { return m_future.result(); }
+
+    private:
+        QFuture<T> m_future;
+    };
+#endif
+
     /**
      * @brief connectReadValue 绑定读取事件
      * @param key 注册过的键，不可为空
@@ -191,7 +569,20 @@ public:
     /**
      * @brief connectReadValue 绑定读取事件
      * @param key 注册过的键，不可为空
-     * @param object 对象
+     * @param context 上下文对象，销毁时自动解绑
+     * @param read_func 读取设置的回调函数
+     * @return 读取事件的 id
+     * @note 解绑在发出 destroyed 的线程中直接执行，会修改读取事件的表；
+     *       上下文对象必须在设置所在的线程（主线程）中销毁，其他线程中的对象应在销毁前手动 disconnectReadValue
+     */
+    template <typename Func, typename = std::enable_if_t<!std::is_member_function_pointer<Func>::value>>
+    static ConnId connectReadValue(const QString& key, const QObject* context, Func read_func);
+
+    /**
+     * @brief connectReadValue 绑定读取事件
+     * @param key 注册过的键，不可为空
+     * @param object 对象，是 QObject 时销毁后自动解绑，否则需要在销毁前手动解绑；
+     *               自动解绑在销毁的线程中执行，需在主线程中销毁
      * @param read_func 对象成员函数读取设置的回调函数
      * @param group 分组号
      * @return 读取事件的 id
@@ -199,6 +590,51 @@ public:
     template <typename Func, typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
     static ConnId connectReadValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func);
 
+    /**
+     * @brief connectReadValuesFromPattern 按模式绑定读取事件，之后注册的匹配键同样会触发
+     * @param pattern 键的模式，`*` 匹配一段，`**` 匹配零或多段，如：组路径之后接 `**` 匹配组下的所有键
+     * @param read_func 读取设置的回调函数，参数为匹配的键和它的值
+     * @return 读取事件的 id
+     * @note 触发某个键时按路径深度在前缀树中查找匹配的模式，与模式的数量无关；
+     *       直接触发这个 id 时会对所有已注册的匹配键各调用一次
+     */
+    static ConnId connectReadValuesFromPattern(
+        const QString& pattern, std::function<void(const QString&, const QVariant&)> read_func
+    );
+
+    /**
+     * @brief connectReadValuesFromPattern 按模式绑定读取事件，之后注册的匹配键同样会触发
+     * @param pattern 键的模式，`*` 匹配一段，`**` 匹配零或多段
+     * @param object 对象，是 QObject 时销毁后自动解绑（需在主线程中销毁）
+     * @param read_func 对象成员函数读取设置的回调函数，参数为匹配的键和它的值
+     * @return 读取事件的 id
+     */
+    template <typename Class>
+    static ConnId connectReadValuesFromPattern(
+        const QString& pattern, Class* object, void (Class::*read_func)(const QString&, const QVariant&)
+    );
+
+    /**
+     * @brief connectValueChanged 绑定值变化事件，回调同时得到旧值和新值
+     * @param key 注册过的键，不可为空
+     * @param changed_func 回调函数，参数为旧值和新值
+     * @return 读取事件的 id，与 connectReadValue 返回的一样可以触发和解绑
+     * @note 旧值和新值在写入时得到（writeValue、setOverride、removeOverride 并触发信号），不需要订阅者自己保存；
+     *       触发前多次写入会合并为第一次的旧值和最后的新值；直接触发时旧值和新值相同
+     */
+    template <typename Func, typename = std::enable_if_t<!std::is_member_function_pointer<Func>::value>>
+    static ConnId connectValueChanged(const QString& key, Func changed_func);
+
+    /**
+     * @brief connectValueChanged 绑定值变化事件，回调同时得到旧值和新值
+     * @param key 注册过的键，不可为空
+     * @param object 对象，是 QObject 时销毁后自动解绑（需在主线程中销毁）
+     * @param changed_func 对象成员函数回调，参数为旧值和新值
+     * @return 读取事件的 id
+     */
+    template <typename Func, typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
+    static ConnId connectValueChanged(const QString& key, lzl::trains_class_type<Func>* object, Func changed_func);
+
     /**
      * @brief disconnectReadValue 解绑读取事件
      * @param id 读取事件的 id, Q_ASSERT(!id.isNull());
@@ -218,7 +654,7 @@ public:
     static void disconnectReadValuesFromGroup(const QString& dir);
 
     /**
-     * @brief disconnectAllSettingsReadValues 解绑所有读取事件
+     * @brief disconnectAllSettingsReadValues 解绑所有读取事件（包括所有作用域）
      */
     static void disconnectAllSettingsReadValues();
 
@@ -231,6 +667,8 @@ public:
     /**
      * @brief emitReadValues 触发读取事件信号
      * @param ids 读取事件的 id 列表, Q_ASSERT(!id.isNull());
+     * @note 在回调中触发的事件不会递归执行，而是在当前一轮结束后执行，每一轮中每个事件最多执行一次，
+     *       且读取的是执行时的最新值；连锁触发超过 MaxEmitCycles 轮后剩余的事件会被丢弃
      */
     static void emitReadValues(const QList<ConnId>& ids);
 
@@ -247,12 +685,34 @@ public:
     static void emitReadValuesFromGroup(const QString& dir);
 
     /**
-     * @brief emitAllSettingsReadValues 触发所有读取事件信号
+     * @brief emitReadValuesFromGroupDeferred 在事件循环中分批触发组的读取事件，用于启动时填充界面
+     * @param dir 存在的组，不可为空
+     * @param priority 与其他延迟触发的批次之间的优先级，越大越先执行
+     * @note 每次事件循环执行的回调不超过 setDeferredEmitBudget 设置的时间（至少执行一个），
+     *       同一批次中 setConnPriority 设置的优先级高的事件先执行；执行时读取的是最新值
+     */
+    static void emitReadValuesFromGroupDeferred(const QString& dir, int priority = 0);
+
+    /**
+     * @brief setConnPriority 设置读取事件在延迟触发中的优先级，默认为 0，可见的控件可以设置得更高
+     * @param id 读取事件的 id, Q_ASSERT(!id.isNull());
+     * @param priority 优先级，越大越先执行
+     */
+    static void setConnPriority(ConnId id, int priority);
+
+    /**
+     * @brief setDeferredEmitBudget 设置延迟触发每次占用事件循环的时间，默认 8 毫秒
+     * @param msecs 毫秒数，不可为负
+     */
+    static void setDeferredEmitBudget(int msecs);
+
+    /**
+     * @brief emitAllSettingsReadValues 触发所有读取事件信号（包括所有作用域）
      */
     static void emitAllSettingsReadValues();
 
     /**
-     * @brief getConnIds 获取所有的读取事件 id 列表
+     * @brief getConnIds 获取所有的读取事件 id 列表（包括所有作用域）
      * @return id 列表, Q_ASSERT(!id.isNull());
      */
     [[nodiscard]] static QList<ConnId> getConnIds() { return s_conns.keys(); }
@@ -271,54 +731,311 @@ public:
      */
     [[nodiscard]] static QList<ConnId> getConnIdsFromGroup(const QString& dir);
 
-    // 构造析构
-private:
-    [[nodiscard]] static Settings& instance();
-    explicit Settings(const QString& filename, QObject* parent = nullptr);
-    ~Settings() = default;
+    /**
+     * @brief statsEnabled 是否编译了统计功能
+     * @return 是否定义了 LZL_QT_SETTINGS_STATS
+     */
+    [[nodiscard]] static constexpr bool statsEnabled() noexcept
+    {
+#ifdef LZL_QT_SETTINGS_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief stats 获取统计数据的快照
+     * @return 所有注册过的键和读取事件的统计数据，未启用统计时为空
+     */
+    [[nodiscard]] static Stats stats();
+
+    /**
+     * @brief dumpStats 将统计数据导出为 JSON
+     * @return JSON 文本，未启用统计时为空对象
+     */
+    [[nodiscard]] static QByteArray dumpStats();
+
+    /**
+     * @brief resetStats 清空统计数据
+     */
+    static void resetStats();
+
+    /**
+     * @brief checkIntegrity 检查内部数据结构的一致性，供压力测试和模糊测试在每次操作之后调用
+     * @return 发现的问题，为空表示一致
+     * @note 检查全局作用域及其子作用域：记录和模式中的读取事件都存在且只属于一处，绑定的读取事件都有所属，
+     *       注册表和模式前缀树中没有空节点，等待触发的队列中没有重复；会遍历所有节点，不要在热路径中调用
+     */
+    [[nodiscard]] static QStringList checkIntegrity();
+
+    /**
+     * @brief traceEnabled 是否编译了追踪功能
+     * @return 是否定义了 LZL_QT_SETTINGS_TRACE
+     */
+    [[nodiscard]] static constexpr bool traceEnabled() noexcept
+    {
+#ifdef LZL_QT_SETTINGS_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief startTrace 开始记录追踪事件（emitReadValue、writeValue、sync）
+     * @param capacity 最多记录的事件数量，超出的事件会被丢弃并计数
+     * @note 会清空之前记录的事件
+     */
+    static void startTrace(int capacity = 1 << 16);
+
+    /**
+     * @brief stopTrace 停止记录追踪事件，已记录的事件会保留
+     */
+    static void stopTrace();
+
+    /**
+     * @brief dumpTrace 将追踪事件导出为 JSON
+     * @return Chrome trace 格式的 JSON 文本，可以直接用 chrome://tracing 或 Perfetto 打开
+     */
+    [[nodiscard]] static QByteArray dumpTrace();
 
     // 静态实例
 private:
-    static Settings* s_instance;
+    [[nodiscard]] static Scope& instance();
+
+    static Scope* s_instance;
     static QString s_ini_directory;
     static QString s_ini_file_name;
 
     // 定义注册表
 private:
-    struct LZL_QT_SETTINGS_EXPORT RegData final
-    {
-        QVariant default_value = {};
-        CheckFunction check_func = {};
-        mutable QList<ConnId> conn_ids = {};
+    /**
+     * @brief SegmentId 路径中一段（如 app、font、size）的驻留 id，0 表示不存在
+     * @note 相同的段在所有作用域的注册表中只保存一份，查找时每段只哈希一次，之后只比较整数；
+     *       驻留表只增不减，查找不加锁，可以在任意线程中进行
+     */
+    using SegmentId = quint32;
+    [[nodiscard]] static SegmentId internSegment(const QString& word);
+    [[nodiscard]] static SegmentId findSegment(const QString& word);
+    [[nodiscard]] static QString segmentName(SegmentId id);
 
-        ~RegData();
-        void clearConns() const;
-    };
-    struct LZL_QT_SETTINGS_EXPORT RegGroup final
+    /**
+     * @brief FlatMap 按段 id 排序的连续数组，代替节点分散在堆上的 QMap
+     * @note 键和值分别连续存放，查找时二分只访问键数组；QVector 隐式共享，复制依然是 O(1) 的
+     */
+    template <typename Value>
+    class FlatMap final
     {
-        using DataSet = QMap<QString, RegData>;
-        using GroupSet = QMap<QString, RegGroup>;
-        DataSet dataset;
-        GroupSet groupset;
+    public:
+        [[nodiscard]] bool isEmpty() const { return m_keys.isEmpty(); }
+        [[nodiscard]] int size() const { return static_cast<int>(m_keys.size()); }
+        [[nodiscard]] SegmentId keyAt(int index) const { return m_keys.at(index); }
+        [[nodiscard]] const Value& valueAt(int index) const { return m_values.at(index); }
+        [[nodiscard]] bool contains(SegmentId key) const { return indexOf(key) >= 0; }
+        [[nodiscard]] const Value* find(SegmentId key) const
+        {
+            const auto index = indexOf(key);
+            return index < 0 ? nullptr : &m_values.at(index);
+        }
+        void clear() { m_keys.clear(), m_values.clear(); }
 
-        // 基本函数
-        [[nodiscard]] bool isEmpty() const { return dataset.isEmpty() && groupset.isEmpty(); }
-        void clear() { dataset.clear(), groupset.clear(); }
+        // 不存在时插入默认值
+        [[nodiscard]] Value& operator[](SegmentId key)
+        {
+            const auto index = lowerBound(key);
+            if (index == size() || m_keys.at(index) != key)
+            {
+                m_keys.insert(index, key);
+                m_values.insert(index, Value());
+            }
+            return m_values[index];
+        }
+
+        // 不存在时返回默认值
+        Value take(SegmentId key)
+        {
+            const auto index = indexOf(key);
+            if (index < 0)
+            {
+                return Value();
+            }
+            auto value = m_values.at(index);
+            m_keys.removeAt(index);
+            m_values.removeAt(index);
+            return value;
+        }
+        void remove(SegmentId key) { take(key); }
 
-        // 通过迭代器 增删改查 <- 现在改为通过指针操作
-        using dataset_iterator = DataSet::iterator;
-        using groupset_iterator = GroupSet::iterator;
+    private:
+        [[nodiscard]] int lowerBound(SegmentId key) const
+        {
+            return static_cast<int>(std::lower_bound(m_keys.cbegin(), m_keys.cend(), key) - m_keys.cbegin());
+        }
+        [[nodiscard]] int indexOf(SegmentId key) const
+        {
+            const auto index = lowerBound(key);
+            return index < size() && m_keys.at(index) == key ? index : -1;
+        }
 
-        [[nodiscard]] bool containsData(const QString& key) { return findData(key) != nullptr; }
-        [[nodiscard]] bool containsGroup(const QString& dir) { return findGroup(dir) != nullptr; }
-        [[nodiscard]] bool containsGroup(const QStringList& words) { return findGroup(words) != nullptr; }
-        [[nodiscard]] RegData* findData(const QString& key);
-        [[nodiscard]] RegGroup* findGroup(const QString& dir);
-        [[nodiscard]] RegGroup* findGroup(const QStringList& words);
+        QVector<SegmentId> m_keys;
+        QVector<Value> m_values;
+    };
 
-        void insertData(const QString& key, const QVariant& default_value, CheckFunction check_func);
-        void removeData(const QString& key);
-        void removeGroup(const QString& dir);
+    /**
+     * @brief CompactValue 注册表和缓存中保存的值，只在接口处转换为 QVariant
+     * @note 不超过 8 字节的标量（bool、整数、double）和 QSize、QPoint 直接保存，坐标在 16 位以内的 QRect 打包保存；
+     *       Qt5 的 QString 只有一个 d 指针，也直接保存，不额外申请堆块；
+     *       Qt6 的字符串（24 字节）和其他类型保存在共享的堆块中，复制只增加引用计数。
+     *       整个值为 16 字节，不超过 QVariant，比较同类型的值时不需要构造 QVariant
+     */
+    class LZL_QT_SETTINGS_EXPORT CompactValue final
+    {
+    public:
+        CompactValue() noexcept { m_data.bits = 0; }
+        CompactValue(const QVariant& value); // 允许隐式构造，记录和缓存可以直接用 QVariant 初始化
+        CompactValue(const CompactValue& other) noexcept;
+        CompactValue(CompactValue&& other) noexcept;
+        CompactValue& operator=(CompactValue other) noexcept;
+        ~CompactValue();
+
+        [[nodiscard]] QVariant toVariant() const;
+        [[nodiscard]] bool operator==(const CompactValue& other) const;
+        [[nodiscard]] bool operator!=(const CompactValue& other) const { return !(*this == other); }
+
+    private:
+        enum class Tag : quint8
+        {
+            Invalid,
+            Bool,
+            Int,
+            UInt,
+            LongLong,
+            ULongLong,
+            Double,
+            Size,
+            Point,
+            Rect,
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+            String,
+#endif
+            Boxed, // 其他类型，保存在共享的堆块中
+        };
+        struct Box; // 定义见源文件
+        union Data
+        {
+            quint64 bits;
+            qint64 integer;
+            double real;
+            qint32 pair[2];
+            qint16 rect[4];
+            Box* box;
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+            alignas(QString) unsigned char string[sizeof(QString)];
+#endif
+        };
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        [[nodiscard]] const QString* string() const;
+#endif
+
+        Data m_data;
+        Tag m_tag = Tag::Invalid;
+    };
+
+    /**
+     * @brief HistoryRing 定长的历史记录环形缓冲区，容量为 0 时不记录
+     */
+    class HistoryRing final
+    {
+    public:
+        HistoryRing() = default;
+        HistoryRing(int capacity, qint64 created) : m_entries(capacity), m_created(created) {}
+
+        [[nodiscard]] bool isEnabled() const { return !m_entries.isEmpty(); }
+        [[nodiscard]] bool isEmpty() const { return m_size == 0; }
+        [[nodiscard]] qint64 created() const { return m_created; }
+        [[nodiscard]] const HistoryEntry& last() const { return at(m_size - 1); }
+        [[nodiscard]] QList<HistoryEntry> entries() const;
+        // 不晚于 timestamp 的最后一条记录，没有时返回空
+        [[nodiscard]] const HistoryEntry* find(qint64 timestamp) const;
+        void append(HistoryEntry&& entry);
+
+    private:
+        [[nodiscard]] const HistoryEntry& at(int index) const
+        {
+            return m_entries.at((m_head + index) % m_entries.size());
+        }
+
+        QVector<HistoryEntry> m_entries;
+        int m_head = 0; // 最旧的记录
+        int m_size = 0;
+        qint64 m_created = 0;
+    };
+    static int s_history_capacity;
+    static int s_parallelism;
+
+    struct LZL_QT_SETTINGS_EXPORT RegData final
+    {
+        CompactValue default_value = {};
+        CheckFunction check_func = {};
+        // 以下可变成员在旧快照中也是同一份，只能在作用域所在的线程中修改
+        mutable QList<ConnId> conn_ids = {};
+#ifdef LZL_QT_SETTINGS_STATS
+        mutable KeyStats stats = {};
+#endif
+        mutable HistoryRing history = {};
+        // 实例中的键指向模板的记录，共享模板的检查函数而不是复制
+        std::shared_ptr<const RegData> schema = {};
+        bool concurrent_check = true; // 检查函数是否可以并行调用
+
+        [[nodiscard]] bool check(const QVariant& value) const
+        {
+            return schema ? schema->check_func(value) : check_func(value);
+        }
+        [[nodiscard]] bool isCheckConcurrent() const { return schema ? schema->concurrent_check : concurrent_check; }
+        // 注销时显式调用，而不是在析构时：旧的快照可能还持有这个记录
+        void clearConns() const;
+    };
+    // 从内存池中分配记录，开启历史记录时一次分配好空间
+    [[nodiscard]] static std::shared_ptr<const RegData> makeRecord(
+        CompactValue default_value,
+        CheckFunction check_func,
+        bool concurrent_check = true,
+        std::shared_ptr<const RegData> schema = {}
+    );
+    /**
+     * @note 注册表是持久化的：子节点存放在隐式共享的连续数组中，复制一个组只增加引用计数，
+     *       修改时只复制路径上的组（见 detachGroup）；记录和组通过共享指针在各个版本之间共享，
+     *       因此旧快照中的节点始终有效。节点从内存池中分配，相邻注册的节点在内存中也相邻
+     */
+    struct LZL_QT_SETTINGS_EXPORT RegGroup final
+    {
+        using DataSet = FlatMap<std::shared_ptr<const RegData>>;
+        using GroupSet = FlatMap<std::shared_ptr<const RegGroup>>;
+        DataSet dataset;
+        GroupSet groupset;
+
+        // 基本函数
+        [[nodiscard]] bool isEmpty() const { return dataset.isEmpty() && groupset.isEmpty(); }
+        void clear() { dataset.clear(), groupset.clear(); }
+
+        [[nodiscard]] bool containsData(const QString& key) const { return findData(key) != nullptr; }
+        [[nodiscard]] bool containsGroup(const QString& dir) const { return findGroup(dir) != nullptr; }
+        [[nodiscard]] bool containsGroup(const QStringList& words) const { return findGroup(words) != nullptr; }
+        [[nodiscard]] QStringList keys(const QString& dir = {}) const;
+        [[nodiscard]] std::shared_ptr<const RegData> findData(const QString& key) const;
+        [[nodiscard]] const RegGroup* findGroup(const QString& dir) const;
+        [[nodiscard]] const RegGroup* findGroup(const QStringList& words) const;
+
+        // 修改只应该作用于新版本的副本
+        [[nodiscard]] RegGroup& detachGroup(SegmentId word);
+        void insertData(
+            const QString& key, const QVariant& default_value, CheckFunction check_func, bool concurrent_check
+        );
+        [[nodiscard]] std::shared_ptr<const RegData> removeData(const QString& key);
+        [[nodiscard]] std::shared_ptr<const RegGroup> removeGroup(const QString& dir);
+        void clearConns() const;
 
         struct ParsedPathPair final
         {
@@ -338,35 +1055,639 @@ private:
          * @return {words, name} 目录各个部分组成的列表和名称
          */
         [[nodiscard]] static ParsedPathPair parsePath(const QString& path);
+        /**
+         * @brief normalizePath 规范化路径，去掉多余的分隔符并统一使用 '/'
+         * @param path 路径
+         * @return 规范化后的路径，已经规范的路径直接返回
+         */
+        [[nodiscard]] static QString normalizePath(const QString& path);
     };
 
-    RegGroup m_regedit;
-    QSettings m_q_settings;
-
-    // 一些非静态的辅助函数
-private:
-    [[nodiscard]] RegData* findRecord(const QString& key);
-    [[nodiscard]] RegGroup* findRegGroup(const QString& dir);
-    [[nodiscard]] QVariant getValue(const QString& key);
-
     // 静态数据
 private:
     struct ConnFunctions final
     {
-        std::function<void(void)> read;
+        // 使用共享指针，保证回调中解绑自己时正在执行的回调依然有效
+        std::shared_ptr<const std::function<void(void)>> read;
         std::function<void(void)> disconnect;
+        Scope* scope = nullptr;    // 通过哪个作用域绑定的
+        bool with_change = false; // 是否需要旧值和新值（见 connectValueChanged）
+        int priority = 0;         // 延迟触发时的优先级（见 setConnPriority）
+        // 与接收者 destroyed 信号的连接，最后一个副本析构（即解绑）时断开
+        std::shared_ptr<const QMetaObject::Connection> receiver = {};
+#ifdef LZL_QT_SETTINGS_STATS
+        const RegData* data = nullptr;
+        ConnStats stats = {};
+#endif
+#ifdef LZL_QT_SETTINGS_TRACE
+        QString key = {};
+#endif
     };
     static QMap<ConnId, ConnFunctions> s_conns;
 
+    /**
+     * @brief PatternNode 模式订阅的前缀树，与注册表一样按段 id 组织，`*` 和 `**` 也作为普通的段保存
+     */
+    struct PatternNode final
+    {
+        QHash<SegmentId, std::shared_ptr<PatternNode>> children;
+        QList<ConnId> conn_ids;
+    };
+    static PatternNode s_patterns;
+    static QHash<ConnId, QStringList> s_emit_keys; // 模式订阅等待触发的键，执行时取出
+
+    // 写入前的旧值按键保存，同一个作用域中绑定这个键的值变化事件共享一份，新值在执行时读取
+    struct ValueChange final
+    {
+        QHash<const Scope*, QVariant> old_values;
+        QSet<ConnId> conn_ids; // 还没有执行的值变化事件，都执行后删除
+    };
+    static QHash<QString, ValueChange> s_emit_changes; // 值变化事件等待触发的旧值，执行时取出
+
+    // 触发读取事件的调度：回调中再次触发的事件会被合并到下一轮，而不是递归执行
+    static constexpr int MaxEmitCycles = 16;
+    static QList<ConnId> s_emit_queue;
+    static QSet<ConnId> s_emit_pending;
+    static bool s_emit_draining;
+
+    // 延迟触发：按批次优先级和事件优先级排序，在事件循环中按时间片执行
+    struct DeferredEmit final
+    {
+        ConnId id;
+        int priority; // 批次的优先级
+    };
+    static QList<DeferredEmit> s_deferred_queue;
+    static QHash<ConnId, QStringList> s_deferred_keys; // 所有等待的事件，模式订阅还有等待触发的键
+    static int s_deferred_budget;
+    static bool s_deferred_scheduled;
+
     // 静态的辅助函数
 private:
     [[nodiscard]] static ConnId generateId();
-    [[nodiscard]] static ConnId insertConn(const RegData* data, std::function<void(void)>&& read_func);
+    [[nodiscard]] static ConnId insertConn(
+        Scope* scope,
+        const QString& key,
+        const std::shared_ptr<const RegData>& data,
+        std::function<void(void)>&& read_func
+    );
+    static void invokeConn(ConnId id, ConnFunctions& conn);
+    // 接收者销毁时立即解绑，触发时不需要检查接收者是否存活；
+    // 解绑在发出 destroyed 的线程中执行，因此接收者必须在设置所在的线程中销毁
+    static void bindReceiver(ConnId id, const QObject* receiver);
+    template <typename Class>
+    static ConnId bindReceiver(ConnId id, Class* object)
+    {
+        if constexpr (std::is_base_of<QObject, Class>::value)
+        {
+            bindReceiver(id, static_cast<const QObject*>(object));
+        }
+        return id;
+    }
+    static void removePatternConn(const QStringList& words, ConnId id);
+    [[nodiscard]] static QList<ConnId> matchPatterns(const QString& key);
+    [[nodiscard]] static bool matchPattern(const QStringList& pattern, const QStringList& words);
+    static void drainEmits();
+    static void deferEmits(const QList<ConnId>& ids, const QHash<ConnId, QStringList>& pattern_keys, int priority);
+    static void runDeferredEmits();
 
     // 用作递归
     static void getConnIdsFromGroup(const RegGroup* group, QList<ConnId>& conn_ids);
+    static void matchPatterns(
+        const PatternNode* node, const QVector<SegmentId>& words, int index, QList<ConnId>& conn_ids
+    );
+#ifdef LZL_QT_SETTINGS_STATS
+    static void collectStats(const RegGroup* group, const QString& dir, Stats& stats);
+    static void resetStats(const RegGroup* group);
+#endif
+};
+
+/**
+ * @brief Settings::Scope 设置的作用域，拥有独立的设置文件和注册表
+ * @note 读取时如果当前作用域的设置文件中没有该键，会依次查找父作用域，最后使用注册的默认值，
+ *       如：文档作用域 -> 用户作用域（全局作用域）-> 注册的默认值
+ * @note 每一层（见 Layer）都会先沿着作用域链查找，再查找下一层：
+ *       运行时覆盖 -> 设置文件 -> 系统设置文件 -> 注册的默认值
+ * @note 查找注册表时同样会依次查找父作用域，因此子作用域可以直接使用父作用域注册的键；
+ *       但注册和注销只作用于当前作用域的注册表
+ * @note 注册表以不可变快照的形式发布，查找时原子地取得当前快照并持有，不需要注册表的互斥锁；
+ *       注册和注销在互斥锁中基于当前快照生成新的快照再原子地替换，旧快照在最后一个持有者释放时回收
+ * @note 取得快照只是一次原子的加载（C++20 为 std::atomic<std::shared_ptr>，否则为 std::atomic_load），
+ *       标准库的实现通常在内部使用很短的自旋锁或锁池，因此不保证无锁，只保证不会等待注册和注销完成
+ * @note 只有注册表的查找（containsKey、containsGroup）可以在其他线程中与注册、注销同时进行，
+ *       但实例不在快照中，其他线程查找时不能同时注册或注销实例；
+ *       读写值、缓存、实例、读取事件、统计和历史记录都不加锁，只能在作用域所在的线程中使用
+ * @note 读取的结果会缓存在当前作用域，只有当前或上层作用域写入、重置、同步或修改注册表时才会失效，
+ *       因此读取时不会每次都沿着作用域链查找
+ * @note 子作用域必须在父作用域之前析构，析构时会解绑所有通过它绑定的读取事件
+ */
+class LZL_QT_SETTINGS_EXPORT Settings::Scope final
+{
+    friend class Settings;
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    Scope(Scope&&) = delete;
+    Scope& operator=(Scope&&) = delete;
+
+public:
+    /**
+     * @brief Scope 创建作用域
+     * @param file_path 设置文件的路径
+     * @param parent 父作用域，为空则是独立的作用域
+     */
+    explicit Scope(const QString& file_path, Scope* parent = nullptr);
+    ~Scope();
+
+    [[nodiscard]] Scope* parent() const noexcept { return m_parent; }
+    [[nodiscard]] QString fileName() const { return m_file_name; }
+    // 读取过设置文件且还没有打开 QSettings（写入之前）时，值来自只读解析；文件不能解析时改用 QSettings，返回 false
+    [[nodiscard]] bool usesIniParser() const;
+
+    void sync();
+    void reset();
+    void reset(const QString& path);
+
+    [[nodiscard]] bool containsKey(const QString& key) { return findData(key) != nullptr; }
+    [[nodiscard]] bool containsGroup(const QString& dir);
+
+    void registerSetting(
+        const QString& key,
+        const QVariant& default_value = {},
+        CheckFunction check_func = [](const QVariant&) -> bool { return true; },
+        bool concurrent_check = true
+    );
+    template <typename Class>
+    void registerSetting(
+        const QString& key, const QVariant& default_value, Class* object, bool (Class::*check_func)(const QVariant&)
+    );
+    void deRegisterSettingKey(const QString& key);
+    void deRegisterSettingGroup(const QString& dir);
+    void deRegisterAllSettings();
+    void registerInstance(const QString& dir, const QString& id, const QVariantHash& defaults = {});
+    void deRegisterInstance(const QString& dir, const QString& id);
+    [[nodiscard]] bool containsInstance(const QString& dir, const QString& id) const;
+
+    bool writeValue(const QString& key, const QVariant& value, bool emit_signal = false);
+
+    void setSystemIniFile(const QString& file_path);
+    bool setOverride(const QString& key, const QVariant& value, bool emit_signal = false);
+    void removeOverride(const QString& key, bool emit_signal = false);
+    void clearOverrides();
+    int loadOverridesFromArguments(const QStringList& arguments, const QString& option = QStringLiteral("--set"));
+    int loadOverridesFromEnvironment(const QString& prefix);
+    [[nodiscard]] Layer effectiveLayer(const QString& key);
+
+    bool loadStartupCache(const QString& cache_path);
+    bool saveStartupCache(const QString& cache_path);
+
+    [[nodiscard]] QList<HistoryEntry> history(const QString& key) const;
+    bool rollbackKey(const QString& key, qint64 timestamp, bool emit_signal = false);
+    int rollbackGroup(const QString& dir, qint64 timestamp, bool emit_signal = false);
+    QList<ValidationIssue> validateAll(int parallelism = 0, bool emit_signal = false);
+
+    int exportGroup(const QString& dir, QIODevice* device, ExportFormat format = ExportFormat::Json);
+    int importGroup(
+        const QString& dir, QIODevice* device, ExportFormat format = ExportFormat::Json, bool emit_signal = false
+    );
+
+    bool setProcessShared(bool shared);
+    [[nodiscard]] bool isProcessShared() const noexcept { return m_shared != nullptr; }
+    int pollSharedChanges(bool emit_signal = false);
+
+    bool attachBroker(const QString& server_name, int timeout_ms = 3000);
+    void detachBroker();
+    [[nodiscard]] bool isBrokerAttached() const noexcept { return m_broker != nullptr; }
+
+    template <typename Func>
+    void readValue(const QString& key, Func read_func);
+    template <typename Func>
+    void readValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func);
+
+    template <typename T>
+    [[nodiscard]] QFuture<T> readValueAsync(const QString& key);
+    [[nodiscard]] QFuture<QVariantHash> readValuesAsync(const QStringList& keys);
+
+    template <typename Func, typename = std::enable_if_t<!std::is_member_function_pointer<Func>::value>>
+    ConnId connectReadValue(const QString& key, Func read_func);
+    template <typename Func, typename = std::enable_if_t<!std::is_member_function_pointer<Func>::value>>
+    ConnId connectReadValue(const QString& key, const QObject* context, Func read_func);
+    template <typename Func, typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
+    ConnId connectReadValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func);
+    ConnId connectReadValuesFromPattern(
+        const QString& pattern, std::function<void(const QString&, const QVariant&)> read_func
+    );
+    template <typename Class>
+    ConnId connectReadValuesFromPattern(
+        const QString& pattern, Class* object, void (Class::*read_func)(const QString&, const QVariant&)
+    );
+    template <typename Func, typename = std::enable_if_t<!std::is_member_function_pointer<Func>::value>>
+    ConnId connectValueChanged(const QString& key, Func changed_func);
+    template <typename Func, typename = std::enable_if_t<std::is_member_function_pointer<Func>::value>>
+    ConnId connectValueChanged(const QString& key, lzl::trains_class_type<Func>* object, Func changed_func);
+
+    // 下面的读取事件只包括通过当前作用域及其子作用域绑定的
+    void disconnectReadValuesFromKey(const QString& key);
+    void disconnectReadValuesFromGroup(const QString& dir);
+    void disconnectAllReadValues();
+    void emitReadValuesFromKey(const QString& key);
+    void emitReadValuesFromGroup(const QString& dir);
+    void emitReadValuesFromGroupDeferred(const QString& dir, int priority = 0);
+    void emitAllReadValues();
+    [[nodiscard]] QList<ConnId> getConnIds() const;
+    [[nodiscard]] QList<ConnId> getConnIdsFromKey(const QString& key);
+    [[nodiscard]] QList<ConnId> getConnIdsFromGroup(const QString& dir);
+
+    void checkIntegrity(QStringList& problems) const;
+
+private:
+    struct CacheEntry final
+    {
+        std::shared_ptr<const RegData> record;
+        CompactValue value;
+        Layer layer;
+    };
+
+    Scope* m_parent;
+    QList<Scope*> m_children;
+#if defined(__cpp_lib_atomic_shared_ptr)
+    std::atomic<std::shared_ptr<const RegGroup>> m_regedit; // 只通过 registry() 和 publishRegistry() 访问
+#else
+    std::shared_ptr<const RegGroup> m_regedit; // C++20 之前的 std::atomic_load/atomic_store 在 C++20 中已经弃用
+#endif
+    QMutex m_regedit_mutex; // 串行化注册表的写入，避免并发的复制-修改-发布丢失更新
+    QString m_file_name;
+    std::unique_ptr<QSettings> m_q_settings; // 第一次写入时才打开，只读时使用 m_ini
+    struct IniFile; // 只读阶段解析的设置文件，打开 QSettings 后丢弃，定义见源文件
+    std::unique_ptr<IniFile> m_ini;
+    std::unique_ptr<QSettings> m_system_settings;
+    QHash<QString, QVariant> m_overrides;
+    QHash<QString, CacheEntry> m_cache;
+    struct SharedState; // 多进程共享模式的状态，定义见源文件
+    std::unique_ptr<SharedState> m_shared;
+    struct BrokerClient; // 本地设置代理的连接，定义见源文件
+    std::unique_ptr<BrokerClient> m_broker;
+    struct AsyncLoad; // 异步读取时在工作线程中加载设置文件，定义见源文件
+    std::unique_ptr<AsyncLoad> m_async;
+    // 模板组的实例，键都是相对于实例的路径：只保存覆盖了的默认值，和绑定了事件或记录了历史的键的记录
+    struct Instance final
+    {
+        QVariantHash defaults;
+        QHash<QString, std::shared_ptr<const RegData>> records;
+        QHash<QString, std::shared_ptr<const RegData>> transients; // 不创建记录的查找返回的临时记录
+    };
+    mutable QHash<QString, QHash<QString, Instance>> m_instances; // 模板组 -> 实例 id -> 实例
+
+    [[nodiscard]] QSettings& settings();
+    // 还没有打开 QSettings 时解析设置文件，不能解析时打开 QSettings 并返回空指针
+    [[nodiscard]] IniFile* iniFile();
+    // 设置文件这一层的读写，连接了代理时使用代理的值；读取的值尽量转换为 like 的类型
+    [[nodiscard]] bool containsUserValue(const QString& key);
+    [[nodiscard]] QVariant userValue(const QString& key, const QVariant& like = {});
+    // 连接的代理已经断开时不修改并返回 false
+    bool setUserValue(const QString& key, const QVariant& value);
+    bool removeUserValue(const QString& path);
+    void clearUserValues();
+    void readBroker();
+    // 作用域链上所有设置文件都已经读入（或连接了代理），读取不会解析文件
+    [[nodiscard]] bool isLoaded() const;
+    void readAsync(const QStringList& keys, std::function<void(const QVariantHash&)>&& resolve);
+    void startAsyncLoad();
+    // 工作线程的加载结果，设置文件不能解析时改用 QSettings
+    using LoadedFile = std::pair<std::unique_ptr<IniFile>, std::unique_ptr<QSettings>>;
+    void finishAsyncLoad(const QList<Scope*>& scopes, std::vector<LoadedFile>& loaded);
+    [[nodiscard]] std::shared_ptr<const RegGroup> registry() const
+    {
+#if defined(__cpp_lib_atomic_shared_ptr)
+        return m_regedit.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&m_regedit, std::memory_order_acquire);
+#endif
+    }
+    // 调用时必须持有 m_regedit_mutex，缓存在释放锁之后由调用者失效
+    void publishRegistry(RegGroup&& regedit);
+    // create 为 false 时实例的键只返回临时的记录，不保存也没有历史，批量操作不会为每个实例的键创建记录
+    [[nodiscard]] std::shared_ptr<const RegData> findData(const QString& key, bool create = false) const;
+    [[nodiscard]] std::shared_ptr<const RegData> findRecord(const QString& key, bool create = false) const;
+    [[nodiscard]] std::shared_ptr<const RegData> findInstanceData(const QString& key, bool create) const;
+    // 修改值时使用的记录，启用了历史时实例的键会创建记录
+    [[nodiscard]] std::shared_ptr<const RegData> historyRecord(const QString& key) const;
+    // 实例中 dir 下的键，dir 为空时返回所有实例的键
+    [[nodiscard]] QStringList instanceKeys(const QString& dir) const;
+    // 注销注册表中的键后调用，删除模板在 path 下的实例记录，path 为空时删除所有
+    void dropInstances(const QString& path);
+    [[nodiscard]] QVariant getValue(const QString& key) { return getEntry(key).value.toVariant(); }
+    [[nodiscard]] const CacheEntry& getEntry(const QString& key);
+    // 与 getEntry 相同，但不计入统计，用于内部的记录
+    [[nodiscard]] const CacheEntry& peekEntry(const QString& key, const std::shared_ptr<const RegData>& record);
+    [[nodiscard]] CacheEntry resolveEntry(const QString& key, const std::shared_ptr<const RegData>& record);
+    // 与 resolveEntry 相同，但不考虑运行时覆盖的值：设置文件、系统设置文件或默认值中最高的一层
+    [[nodiscard]] CacheEntry persistedEntry(const QString& key, const std::shared_ptr<const RegData>& record);
+    [[nodiscard]] QStringList visibleKeys();
+    [[nodiscard]] QStringList groupKeys(const QString& dir);
+    [[nodiscard]] QList<ConnId> queuePatternKeys(const QStringList& keys) const;
+    [[nodiscard]] ConnId insertChangeConn(
+        const QString& key, std::function<void(const QVariant&, const QVariant&)>&& changed_func
+    );
+    // 写入前每个作用域只读取一次旧值，写入后合并到等待触发的值变化中
+    [[nodiscard]] ValueChange captureChanges(const QString& key);
+    static void queueChanges(const QString& key, const ValueChange& change);
+    [[nodiscard]] bool isOverridden(const QString& key) const;
+    // 修改前后调用：记录为空时先记下修改前的值，修改后当前值或来源变化时追加记录
+    void beginHistory(const QString& key, const std::shared_ptr<const RegData>& record);
+    void commitHistory(const QString& key, const std::shared_ptr<const RegData>& record);
+    int rollbackKeys(const QStringList& keys, qint64 timestamp, bool emit_signal);
+    // 从外部重新读取键的前后调用：先记下旧值，重新读取后使缓存失效，只对值变化的键记录历史并触发
+    struct ReloadEntry final
+    {
+        QString key;
+        std::shared_ptr<const RegData> record;
+        QVariant old_value;
+        ValueChange changes;
+    };
+    [[nodiscard]] QList<ReloadEntry> beginReload(const QStringList& keys, bool emit_signal);
+    int endReload(QList<ReloadEntry>& reloads, bool emit_signal);
+    // 重新读取后一起解析失效的键，检查按 setParallelism 并行，结果写入缓存
+    void resolveEntries(const QList<ReloadEntry>& reloads);
+    // 批量修改之后一起触发，changes 是每个键修改前 captureChanges 的结果
+    void emitChangedKeys(const QStringList& keys, const QList<ValueChange>& changes);
+    // 多进程共享模式下修改设置文件前后调用，可以嵌套；最外层结束时同步文件并发布修改的键
+    void beginSharedWrite();
+    void endSharedWrite(const QStringList& keys, bool reload_all = false);
+    [[nodiscard]] QByteArray schemaHash();
+    [[nodiscard]] QByteArray fileStamps() const;
+    [[nodiscard]] bool covers(const Scope* scope) const;
+    [[nodiscard]] QList<ConnId> filterConns(const QList<ConnId>& conn_ids) const;
+
+    // 使当前及所有子作用域的缓存失效
+    void invalidateKey(const QString& key);
+    void invalidatePath(const QString& path);
 };
 
+/**
+ * @brief Settings::Broker 本地设置代理，在内存中保存一份解析好的设置文件，通过本地套接字为多个进程服务
+ * @note 客户端通过 Scope::attachBroker 连接，连接时一次往返取得所有值；客户端的写入和删除由代理写入设置文件，
+ *       每批消息处理完后同步到文件，再推送给其他客户端。需要开启 LZL_QT_SETTINGS_ENABLE_BROKER（链接 Qt Network），
+ *       否则无法监听
+ * @note 单条消息超过 16 MiB 或无法解析时断开发送的客户端
+ * @note 在拥有事件循环的线程中使用
+ */
+class LZL_QT_SETTINGS_EXPORT Settings::Broker final
+{
+    Broker(const Broker&) = delete;
+    Broker& operator=(const Broker&) = delete;
+    Broker(Broker&&) = delete;
+    Broker& operator=(Broker&&) = delete;
+
+public:
+    /**
+     * @brief Broker 创建代理并读入设置文件
+     * @param file_path 设置文件的路径
+     */
+    explicit Broker(const QString& file_path);
+    ~Broker();
+
+    /**
+     * @brief listen 开始监听
+     * @param server_name 本地套接字的名称，会先移除同名的残留套接字
+     * @return 是否成功
+     */
+    bool listen(const QString& server_name);
+
+    /**
+     * @brief close 停止监听并断开所有客户端，设置会写回文件
+     */
+    void close();
+
+    [[nodiscard]] bool isListening() const;
+    [[nodiscard]] int clientCount() const;
+
+private:
+    struct State; // 定义见源文件
+    std::unique_ptr<State> m_state;
+};
+
+// 下面是静态接口转发到全局作用域的实现
+/* ========================================================================== */
+
+inline void Settings::sync()
+{
+    instance().sync();
+}
+
+inline void Settings::reset()
+{
+    instance().reset();
+}
+
+inline void Settings::reset(const QString& path)
+{
+    instance().reset(path);
+}
+
+inline bool Settings::containsKey(const QString& key)
+{
+    return instance().containsKey(key);
+}
+
+inline bool Settings::containsGroup(const QString& dir)
+{
+    return instance().containsGroup(dir);
+}
+
+inline void Settings::registerSetting(
+    const QString& key, const QVariant& default_value, CheckFunction check_func, bool concurrent_check
+)
+{
+    instance().registerSetting(key, default_value, std::move(check_func), concurrent_check);
+}
+
+inline void Settings::setSystemIniFile(const QString& file_path)
+{
+    instance().setSystemIniFile(file_path);
+}
+
+inline bool Settings::setOverride(const QString& key, const QVariant& value, bool emit_signal)
+{
+    return instance().setOverride(key, value, emit_signal);
+}
+
+inline void Settings::removeOverride(const QString& key, bool emit_signal)
+{
+    instance().removeOverride(key, emit_signal);
+}
+
+inline void Settings::clearOverrides()
+{
+    instance().clearOverrides();
+}
+
+inline int Settings::loadOverridesFromArguments(const QStringList& arguments, const QString& option)
+{
+    return instance().loadOverridesFromArguments(arguments, option);
+}
+
+inline int Settings::loadOverridesFromEnvironment(const QString& prefix)
+{
+    return instance().loadOverridesFromEnvironment(prefix);
+}
+
+inline Settings::Layer Settings::effectiveLayer(const QString& key)
+{
+    return instance().effectiveLayer(key);
+}
+
+inline bool Settings::loadStartupCache(const QString& cache_path)
+{
+    return instance().loadStartupCache(cache_path);
+}
+
+inline bool Settings::saveStartupCache(const QString& cache_path)
+{
+    return instance().saveStartupCache(cache_path);
+}
+
+inline QList<Settings::HistoryEntry> Settings::history(const QString& key)
+{
+    return instance().history(key);
+}
+
+inline int Settings::exportGroup(const QString& dir, QIODevice* device, ExportFormat format)
+{
+    return instance().exportGroup(dir, device, format);
+}
+
+inline int Settings::importGroup(const QString& dir, QIODevice* device, ExportFormat format, bool emit_signal)
+{
+    return instance().importGroup(dir, device, format, emit_signal);
+}
+
+inline bool Settings::setProcessShared(bool shared)
+{
+    return instance().setProcessShared(shared);
+}
+
+inline bool Settings::isProcessShared()
+{
+    return instance().isProcessShared();
+}
+
+inline int Settings::pollSharedChanges(bool emit_signal)
+{
+    return instance().pollSharedChanges(emit_signal);
+}
+
+inline bool Settings::attachBroker(const QString& server_name, int timeout_ms)
+{
+    return instance().attachBroker(server_name, timeout_ms);
+}
+
+inline void Settings::detachBroker()
+{
+    instance().detachBroker();
+}
+
+inline bool Settings::isBrokerAttached()
+{
+    return instance().isBrokerAttached();
+}
+
+inline bool Settings::rollbackKey(const QString& key, qint64 timestamp, bool emit_signal)
+{
+    return instance().rollbackKey(key, timestamp, emit_signal);
+}
+
+inline int Settings::rollbackGroup(const QString& dir, qint64 timestamp, bool emit_signal)
+{
+    return instance().rollbackGroup(dir, timestamp, emit_signal);
+}
+
+inline QList<Settings::ValidationIssue> Settings::validateAll(int parallelism, bool emit_signal)
+{
+    return instance().validateAll(parallelism, emit_signal);
+}
+
+inline Settings::ConnId Settings::connectReadValuesFromPattern(
+    const QString& pattern, std::function<void(const QString&, const QVariant&)> read_func
+)
+{
+    return instance().connectReadValuesFromPattern(pattern, std::move(read_func));
+}
+
+inline QFuture<QVariantHash> Settings::readValuesAsync(const QStringList& keys)
+{
+    return instance().readValuesAsync(keys);
+}
+
+inline void Settings::deRegisterSettingKey(const QString& key)
+{
+    instance().deRegisterSettingKey(key);
+}
+
+inline void Settings::deRegisterSettingGroup(const QString& dir)
+{
+    instance().deRegisterSettingGroup(dir);
+}
+
+inline void Settings::deRegisterAllSettings()
+{
+    instance().deRegisterAllSettings();
+}
+
+inline void Settings::registerInstance(const QString& dir, const QString& id, const QVariantHash& defaults)
+{
+    instance().registerInstance(dir, id, defaults);
+}
+
+inline void Settings::deRegisterInstance(const QString& dir, const QString& id)
+{
+    instance().deRegisterInstance(dir, id);
+}
+
+inline bool Settings::containsInstance(const QString& dir, const QString& id)
+{
+    return instance().containsInstance(dir, id);
+}
+
+inline bool Settings::writeValue(const QString& key, const QVariant& value, bool emit_signal)
+{
+    return instance().writeValue(key, value, emit_signal);
+}
+
+inline void Settings::disconnectReadValuesFromKey(const QString& key)
+{
+    instance().disconnectReadValuesFromKey(key);
+}
+
+inline void Settings::disconnectReadValuesFromGroup(const QString& dir)
+{
+    instance().disconnectReadValuesFromGroup(dir);
+}
+
+inline void Settings::emitReadValuesFromKey(const QString& key)
+{
+    instance().emitReadValuesFromKey(key);
+}
+
+inline void Settings::emitReadValuesFromGroup(const QString& dir)
+{
+    instance().emitReadValuesFromGroup(dir);
+}
+
+inline void Settings::emitReadValuesFromGroupDeferred(const QString& dir, int priority)
+{
+    instance().emitReadValuesFromGroupDeferred(dir, priority);
+}
+
+inline QList<Settings::ConnId> Settings::getConnIdsFromKey(const QString& key)
+{
+    return instance().getConnIdsFromKey(key);
+}
+
+inline QList<Settings::ConnId> Settings::getConnIdsFromGroup(const QString& dir)
+{
+    return instance().getConnIdsFromGroup(dir);
+}
+
 // 下面是模板函数的实现
 /* ========================================================================== */
 
@@ -375,43 +1696,176 @@ inline void Settings::registerSetting(
     const QString& key, const QVariant& default_value, Class* object, bool (Class::*check_func)(const QVariant&)
 )
 {
-    registerSetting(key, default_value, [object, check_func](const QVariant& value) {
-        return (object->*check_func)(value);
-    });
+    instance().registerSetting(key, default_value, object, check_func);
 }
 
 template <typename Func>
 inline void Settings::readValue(const QString& key, Func read_func)
+{
+    instance().readValue(key, std::move(read_func));
+}
+
+template <typename Func>
+inline void Settings::readValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func)
+{
+    instance().readValue(key, object, read_func);
+}
+
+template <typename T>
+inline QFuture<T> Settings::readValueAsync(const QString& key)
+{
+    return instance().template readValueAsync<T>(key);
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::connectReadValue(const QString& key, Func read_func)
+{
+    return instance().connectReadValue(key, std::move(read_func));
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::connectReadValue(const QString& key, const QObject* context, Func read_func)
+{
+    return instance().connectReadValue(key, context, std::move(read_func));
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::connectReadValue(
+    const QString& key, lzl::trains_class_type<Func>* object, Func read_func
+)
+{
+    return instance().connectReadValue(key, object, read_func);
+}
+
+template <typename Class>
+inline Settings::ConnId Settings::connectReadValuesFromPattern(
+    const QString& pattern, Class* object, void (Class::*read_func)(const QString&, const QVariant&)
+)
+{
+    return instance().connectReadValuesFromPattern(pattern, object, read_func);
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::connectValueChanged(const QString& key, Func changed_func)
+{
+    return instance().connectValueChanged(key, std::move(changed_func));
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::connectValueChanged(
+    const QString& key, lzl::trains_class_type<Func>* object, Func changed_func
+)
+{
+    return instance().connectValueChanged(key, object, changed_func);
+}
+
+template <typename Class>
+inline void Settings::Scope::registerSetting(
+    const QString& key, const QVariant& default_value, Class* object, bool (Class::*check_func)(const QVariant&)
+)
+{
+    // 对象的成员函数可能访问对象的状态，不能并行调用
+    registerSetting(
+        key,
+        default_value,
+        [object, check_func](const QVariant& value) { return (object->*check_func)(value); },
+        false
+    );
+}
+
+template <typename Func>
+inline void Settings::Scope::readValue(const QString& key, Func read_func)
 {
     using arg_type = typename lzl::function_traits<Func>::template arg<0>::type;
     Q_STATIC_ASSERT(lzl::function_traits<Func>::arity == 1);
-    read_func(ConvertQVariant<arg_type>::convert(instance().getValue(key)));
+    read_func(ConvertQVariant<arg_type>::convert(getValue(key)));
 }
 
 template <typename Func>
-inline void Settings::readValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func)
+inline void Settings::Scope::readValue(const QString& key, lzl::trains_class_type<Func>* object, Func read_func)
 {
     using arg_type = typename lzl::function_traits<Func>::template arg<0>::type;
     Q_STATIC_ASSERT(lzl::function_traits<Func>::arity == 1);
-    (object->*read_func)(ConvertQVariant<arg_type>::convert(instance().getValue(key)));
+    (object->*read_func)(ConvertQVariant<arg_type>::convert(getValue(key)));
+}
+
+template <typename T>
+inline QFuture<T> Settings::Scope::readValueAsync(const QString& key)
+{
+    QFutureInterface<T> promise;
+    promise.reportStarted();
+    readAsync({key}, [promise, key](const QVariantHash& values) mutable {
+        // 与同步读取使用同样的转换，同一个键的结果不会因为读取方式不同而不同
+        promise.reportResult(ConvertQVariant<T>::convert(values.value(key)));
+        promise.reportFinished();
+    });
+    return promise.future();
 }
 
 template <typename Func, typename>
-inline Settings::ConnId Settings::connectReadValue(const QString& key, Func read_func)
+inline Settings::ConnId Settings::Scope::connectReadValue(const QString& key, Func read_func)
 {
-    return insertConn(instance().findRecord(key), [key, read_func = std::move(read_func)]() {
-        instance().readValue(key, read_func);
+    return insertConn(this, key, findRecord(key, true), [this, key, read_func = std::move(read_func)]() {
+        readValue(key, read_func);
     });
 }
 
 template <typename Func, typename>
-inline Settings::ConnId Settings::connectReadValue(
+inline Settings::ConnId Settings::Scope::connectReadValue(
     const QString& key, lzl::trains_class_type<Func>* object, Func read_func
 )
 {
-    return insertConn(instance().findRecord(key), [key, object, read_func = std::move(read_func)]() {
-        instance().readValue(key, object, read_func);
+    auto read = [this, key, object, read_func = std::move(read_func)]() { readValue(key, object, read_func); };
+    const auto id = insertConn(this, key, findRecord(key, true), std::move(read));
+    return bindReceiver(id, object);
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::Scope::connectReadValue(const QString& key, const QObject* context, Func read_func)
+{
+    Q_ASSERT(context != nullptr);
+    const auto id = connectReadValue(key, std::move(read_func));
+    bindReceiver(id, context);
+    return id;
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::Scope::connectValueChanged(const QString& key, Func changed_func)
+{
+    using old_type = typename lzl::function_traits<Func>::template arg<0>::type;
+    using new_type = typename lzl::function_traits<Func>::template arg<1>::type;
+    Q_STATIC_ASSERT(lzl::function_traits<Func>::arity == 2);
+    auto changed = [changed_func = std::move(changed_func)](const QVariant& old_value, const QVariant& new_value) {
+        changed_func(ConvertQVariant<old_type>::convert(old_value), ConvertQVariant<new_type>::convert(new_value));
+    };
+    return insertChangeConn(key, std::move(changed));
+}
+
+template <typename Func, typename>
+inline Settings::ConnId Settings::Scope::connectValueChanged(
+    const QString& key, lzl::trains_class_type<Func>* object, Func changed_func
+)
+{
+    using old_type = typename lzl::function_traits<Func>::template arg<0>::type;
+    using new_type = typename lzl::function_traits<Func>::template arg<1>::type;
+    Q_STATIC_ASSERT(lzl::function_traits<Func>::arity == 2);
+    const auto id = insertChangeConn(key, [object, changed_func](const QVariant& old_value, const QVariant& new_value) {
+        (object->*changed_func)(
+            ConvertQVariant<old_type>::convert(old_value), ConvertQVariant<new_type>::convert(new_value)
+        );
     });
+    return bindReceiver(id, object);
+}
+
+template <typename Class>
+inline Settings::ConnId Settings::Scope::connectReadValuesFromPattern(
+    const QString& pattern, Class* object, void (Class::*read_func)(const QString&, const QVariant&)
+)
+{
+    const auto id = connectReadValuesFromPattern(
+        pattern, [object, read_func](const QString& key, const QVariant& value) { (object->*read_func)(key, value); }
+    );
+    return bindReceiver(id, object);
 }
 
 } // namespace lzl::utils
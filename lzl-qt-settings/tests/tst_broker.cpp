@@ -0,0 +1,175 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QSettings>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+#include <QUuid>
+
+#include <memory>
+
+namespace {
+
+const auto Key = QStringLiteral("app/name");
+const auto CountKey = QStringLiteral("app/count");
+
+/**
+ * @brief BrokerThread 在自己的线程中运行代理，客户端连接时会阻塞当前线程等待代理的回复
+ */
+class BrokerThread final
+{
+public:
+    explicit BrokerThread(const QString& file_path)
+    {
+        m_context.moveToThread(&m_thread);
+        m_thread.start();
+        run([this, file_path] { m_broker = std::make_unique<lzl::Settings::Broker>(file_path); });
+    }
+
+    ~BrokerThread()
+    {
+        // 代理的套接字属于代理的线程，必须在其中析构
+        run([this] { m_broker.reset(); });
+        m_thread.quit();
+        m_thread.wait();
+    }
+
+    bool listen(const QString& server_name)
+    {
+        auto listening = false;
+        run([this, &server_name, &listening] { listening = m_broker->listen(server_name); });
+        return listening;
+    }
+
+    void close()
+    {
+        run([this] { m_broker->close(); });
+    }
+
+private:
+    template <typename Func>
+    void run(Func func)
+    {
+        QMetaObject::invokeMethod(&m_context, std::move(func), Qt::BlockingQueuedConnection);
+    }
+
+    QThread m_thread;
+    QObject m_context;
+    std::unique_ptr<lzl::Settings::Broker> m_broker;
+};
+
+QString uniqueServerName()
+{
+    return QStringLiteral("lzl-settings-test-") + QUuid::createUuid().toString(QUuid::WithoutBraces);
+}
+
+QString valueOf(lzl::Settings::Scope& scope, const QString& key)
+{
+    QString value;
+    scope.readValue(key, [&value](const QString& read) { value = read; });
+    return value;
+}
+
+} // namespace
+
+class TestBroker final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void propagatesWritesBetweenScopes();
+    void rejectsWritesWhileDisconnected();
+    void convertsValuesToDefaultType();
+};
+
+void TestBroker::propagatesWritesBetweenScopes()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto file_path = dir.filePath(QStringLiteral("config.ini"));
+    const auto server_name = uniqueServerName();
+    BrokerThread broker(file_path);
+    QVERIFY(broker.listen(server_name));
+
+    // 两个作用域使用同一个设置文件，都通过代理读写
+    lzl::Settings::Scope writer(file_path);
+    lzl::Settings::Scope reader(file_path);
+    for (auto scope : {&writer, &reader})
+    {
+        scope->registerSetting(Key, QStringLiteral("default"));
+        QVERIFY(scope->attachBroker(server_name));
+    }
+
+    auto changes = 0;
+    QString old_value;
+    QString new_value;
+    reader.connectValueChanged(Key, [&](const QString& old_read, const QString& new_read) {
+        ++changes;
+        old_value = old_read;
+        new_value = new_read;
+    });
+
+    QVERIFY(writer.writeValue(Key, QStringLiteral("written"), true));
+    QTRY_COMPARE(changes, 1);
+    QCOMPARE(old_value, QStringLiteral("default"));
+    QCOMPARE(new_value, QStringLiteral("written"));
+    QCOMPARE(valueOf(reader, Key), QStringLiteral("written"));
+
+    // 代理推送之前已经写回文件，断开后从文件中读到同样的值
+    reader.detachBroker();
+    QCOMPARE(valueOf(reader, Key), QStringLiteral("written"));
+    QCOMPARE(QSettings(file_path, QSettings::IniFormat).value(Key).toString(), QStringLiteral("written"));
+}
+
+void TestBroker::rejectsWritesWhileDisconnected()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto file_path = dir.filePath(QStringLiteral("config.ini"));
+    const auto server_name = uniqueServerName();
+    BrokerThread broker(file_path);
+    QVERIFY(broker.listen(server_name));
+
+    lzl::Settings::Scope scope(file_path);
+    scope.registerSetting(Key, QStringLiteral("default"));
+    QVERIFY(scope.attachBroker(server_name));
+
+    // 断开在事件循环中才能得知，之后的写入不会只修改本地的值
+    broker.close();
+    QTRY_VERIFY(!scope.writeValue(Key, QStringLiteral("lost")));
+    QVERIFY(!scope.writeValue(Key, QStringLiteral("dropped")));
+    QVERIFY(valueOf(scope, Key) != QStringLiteral("dropped"));
+}
+
+void TestBroker::convertsValuesToDefaultType()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto file_path = dir.filePath(QStringLiteral("config.ini"));
+    // 设置文件中的整数是文本，代理启动时用 QSettings 读出的也是字符串
+    QSettings(file_path, QSettings::IniFormat).setValue(CountKey, 42);
+    const auto server_name = uniqueServerName();
+    BrokerThread broker(file_path);
+    QVERIFY(broker.listen(server_name));
+
+    lzl::Settings::Scope scope(file_path);
+    scope.registerSetting(CountKey, 0);
+    QVERIFY(scope.attachBroker(server_name));
+
+    // 和直接读取设置文件一样转换为默认值的类型
+    const auto value = scope.readValuesAsync({CountKey}).result().value(CountKey);
+    QCOMPARE(value.userType(), static_cast<int>(QMetaType::Int));
+    QCOMPARE(value.toInt(), 42);
+}
+
+QTEST_GUILESS_MAIN(TestBroker)
+
+#include "tst_broker.moc"
@@ -0,0 +1,147 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QBuffer>
+#include <QFuture>
+#include <QPoint>
+#include <QRect>
+#include <QSize>
+#include <QTemporaryDir>
+#include <QTest>
+
+Q_DECLARE_METATYPE(lzl::Settings::ExportFormat)
+
+namespace {
+
+const auto Group = QStringLiteral("app");
+
+// 默认值和写入的值，类型各不相同
+const QList<QPair<QString, QPair<QVariant, QVariant>>>& entries()
+{
+    static const QList<QPair<QString, QPair<QVariant, QVariant>>> entries{
+        {QStringLiteral("app/name"), {QStringLiteral("default"), QStringLiteral("a, \"quoted\" name")}},
+        {QStringLiteral("app/count"), {0, 42}},
+        {QStringLiteral("app/ratio"), {1.0, 2.5}},
+        {QStringLiteral("app/enabled"), {false, true}},
+        {QStringLiteral("app/window/size"), {QSize(1, 1), QSize(640, 480)}},
+        {QStringLiteral("app/window/pos"), {QPoint(), QPoint(-3, 7)}},
+        {QStringLiteral("app/window/rect"), {QRect(), QRect(1, 2, 30, 40)}},
+        {QStringLiteral("app/recent"), {QStringList(), QStringList{QStringLiteral("x"), QStringLiteral("y, z")}}},
+        {QStringLiteral("app/escaped"), {QString(), QStringLiteral("@literal")}},
+    };
+    return entries;
+}
+
+void registerAll(lzl::Settings::Scope& scope)
+{
+    for (const auto& [key, values] : entries())
+    {
+        scope.registerSetting(key, values.first);
+    }
+}
+
+QVariantHash valuesOf(lzl::Settings::Scope& scope)
+{
+    QStringList keys;
+    for (const auto& entry : entries())
+    {
+        keys.append(entry.first);
+    }
+    auto future = scope.readValuesAsync(keys);
+    if (!QTest::qWaitFor([&future]() { return future.isFinished(); }))
+    {
+        return {};
+    }
+    return future.result();
+}
+
+} // namespace
+
+class TestExport final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void exportsPersistedValueOfOverriddenKey();
+    void rejectsCorruptData();
+};
+
+void TestExport::roundTrip_data()
+{
+    QTest::addColumn<lzl::Settings::ExportFormat>("format");
+    QTest::newRow("json") << lzl::Settings::ExportFormat::Json;
+    QTest::newRow("binary") << lzl::Settings::ExportFormat::Binary;
+}
+
+void TestExport::roundTrip()
+{
+    QFETCH(lzl::Settings::ExportFormat, format);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    lzl::Settings::Scope source(dir.filePath(QStringLiteral("source.ini")));
+    registerAll(source);
+    for (const auto& [key, values] : entries())
+    {
+        QVERIFY(source.writeValue(key, values.second));
+    }
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QCOMPARE(source.exportGroup(Group, &buffer, format), static_cast<int>(entries().size()));
+    buffer.close();
+
+    // 导入到另一个设置文件后读到同样的值和类型
+    lzl::Settings::Scope target(dir.filePath(QStringLiteral("target.ini")));
+    registerAll(target);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QCOMPARE(target.importGroup(Group, &buffer, format), static_cast<int>(entries().size()));
+    const auto values = valuesOf(target);
+    for (const auto& [key, expected] : entries())
+    {
+        QCOMPARE(values.value(key), expected.second);
+    }
+}
+
+void TestExport::exportsPersistedValueOfOverriddenKey()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    lzl::Settings::Scope scope(dir.filePath(QStringLiteral("config.ini")));
+    registerAll(scope);
+    QVERIFY(scope.writeValue(QStringLiteral("app/count"), 7));
+    QVERIFY(scope.setOverride(QStringLiteral("app/count"), 99));
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QCOMPARE(scope.exportGroup(Group, &buffer), static_cast<int>(entries().size()));
+    QVERIFY(buffer.data().contains("{\"key\":\"count\",\"value\":7}"));
+    QVERIFY(!buffer.data().contains("99"));
+}
+
+void TestExport::rejectsCorruptData()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    lzl::Settings::Scope scope(dir.filePath(QStringLiteral("config.ini")));
+    registerAll(scope);
+
+    // 第一行合法，第二行损坏：不写入任何条目
+    QBuffer buffer;
+    buffer.setData("{\"key\":\"count\",\"value\":5}\nnot json\n");
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QCOMPARE(scope.importGroup(Group, &buffer), -1);
+    QCOMPARE(valuesOf(scope).value(QStringLiteral("app/count")), QVariant(0));
+}
+
+QTEST_GUILESS_MAIN(TestExport)
+
+#include "tst_export.moc"
@@ -0,0 +1,99 @@
+/**
+ * License: GPLv3 LGPLv3
+ * Copyright (c) 2024-2025 李宗霖 (Li Zonglin)
+ * Email: supine0703@outlook.com
+ * GitHub: https://github.com/supine0703
+ * Repository: https://github.com/supine0703/qt-settings
+ */
+
+#include "lzl/settings"
+
+#include <QFuture>
+#include <QPoint>
+#include <QRect>
+#include <QSettings>
+#include <QSize>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace {
+
+// QSettings 写出的各种写法：@ 开头的类型、需要 %XX 转义的键、需要引号和转义的值、[General] 和名为 General 的组
+QVariantHash roundTripValues()
+{
+    return {
+        {QStringLiteral("plain"), QStringLiteral("text")},
+        {QStringLiteral("General/inner"), QStringLiteral("general group")},
+        {QStringLiteral("types/size"), QSize(640, 480)},
+        {QStringLiteral("types/point"), QPoint(-3, 7)},
+        {QStringLiteral("types/rect"), QRect(1, 2, 30, 40)},
+        {QStringLiteral("types/int"), 42},
+        {QStringLiteral("types/list"), QStringList{QStringLiteral("x"), QStringLiteral("y, z")}},
+        {QStringLiteral("keys/with space"), QStringLiteral("space")},
+        {QStringLiteral("keys/x=y"), QStringLiteral("equals")},
+        {QStringLiteral("keys/semi;colon"), QStringLiteral("semicolon")},
+        {QStringLiteral("keys/键"), QStringLiteral("中文")},
+        {QStringLiteral("values/comma"), QStringLiteral("a, b")},
+        {QStringLiteral("values/padded"), QStringLiteral("  padded  ")},
+        {QStringLiteral("values/escaped"), QStringLiteral("tab\tline\nquote\"back\\slash")},
+        {QStringLiteral("values/at"), QStringLiteral("@literal")},
+        {QStringLiteral("values/semicolon"), QStringLiteral("a;b")},
+        {QStringLiteral("values/empty"), QString()},
+    };
+}
+
+// 默认值决定读取时转换的类型
+QVariant defaultLike(const QVariant& value)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return QVariant(value.metaType());
+#else
+    return QVariant(value.userType(), nullptr);
+#endif
+}
+
+} // namespace
+
+class TestIni final : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readsValuesWrittenByQSettings();
+};
+
+void TestIni::readsValuesWrittenByQSettings()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto file_path = dir.filePath(QStringLiteral("config.ini"));
+    const auto values = roundTripValues();
+    {
+        QSettings settings(file_path, QSettings::IniFormat);
+        for (auto it = values.cbegin(); it != values.cend(); ++it)
+        {
+            settings.setValue(it.key(), it.value());
+        }
+    }
+
+    lzl::Settings::Scope scope(file_path);
+    for (auto it = values.cbegin(); it != values.cend(); ++it)
+    {
+        scope.registerSetting(it.key(), defaultLike(it.value()));
+    }
+
+    // 第一次读取在工作线程中解析文件
+    auto future = scope.readValuesAsync(values.keys());
+    QTRY_VERIFY(future.isFinished());
+    const auto read = future.result();
+    for (auto it = values.cbegin(); it != values.cend(); ++it)
+    {
+        QCOMPARE(read.value(it.key()), it.value());
+    }
+    // 所有写法都由只读解析读取，而不是退回 QSettings
+    QVERIFY(scope.usesIniParser());
+}
+
+QTEST_GUILESS_MAIN(TestIni)
+
+#include "tst_ini.moc"
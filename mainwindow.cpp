@@ -77,7 +77,7 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
         return false;
     });
     // 绑定设置事件
-    id1 = lzl::Settings::connectReadValue("app/font/size", [this, button1](double size) {
+    id1 = lzl::Settings::connectReadValue("app/font/size", this, [this, button1](double size) {
         auto font = QApplication::font();
         font.setPointSizeF(size);
         QApplication::setFont(font);
@@ -88,8 +88,9 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::MainWi
     });
     id2 = lzl::Settings::connectReadValue("app/window/size", this, &MainWindow::resize);
     id3 = lzl::Settings::connectReadValue("app/window/pos", this, &MainWindow::move);
-    // 读取设置
-    lzl::Settings::emitReadValuesFromGroup("app");
+    // 读取设置：窗口的位置和大小在显示前应用，字体的回调会重新布局，放到事件循环中执行
+    lzl::Settings::emitReadValuesFromGroup("app/window");
+    lzl::Settings::emitReadValuesFromGroupDeferred("app/font");
 
     // 进行全局设置的验证
     int i;